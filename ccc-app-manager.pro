@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui dtkwidget svg network
+QT       += core gui dtkwidget svg network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -29,19 +29,45 @@ SOURCES += \
         src/mainwindow.cpp \
     src/appmanagerwidget.cpp \
     src/appmanagermodel.cpp \
+    src/applistmodel.cpp \
+    src/filelistmodel.cpp \
     src/job/appmanagerjob.cpp \
+    src/job/appsearchjob.cpp \
     src/common/appmanagercommon.cpp \
+    src/common/pinyintable.cpp \
     src/dlg/pkgdownloaddlg.cpp \
-    src/pkgmonitor/pkgmonitor.cpp
+    src/download/pkgdownloadmanager.cpp \
+    src/download/pkgdownloadtask.cpp \
+    src/download/pkgfilecache.cpp \
+    src/pkgmonitor/pkgmonitor.cpp \
+    src/stallmonitor/stallmonitor.cpp \
+    src/search/appsearchindex.cpp \
+    src/search/appdescindex.cpp \
+    src/search/fuzzymatcher.cpp \
+    src/search/asciinametable.cpp \
+    src/search/appquery.cpp
 
 HEADERS += \
         src/mainwindow.h \
     src/appmanagerwidget.h \
     src/appmanagermodel.h \
+    src/applistmodel.h \
+    src/filelistmodel.h \
     src/job/appmanagerjob.h \
+    src/job/appsearchjob.h \
     src/common/appmanagercommon.h \
+    src/common/pinyintable.h \
     src/dlg/pkgdownloaddlg.h \
-    src/pkgmonitor/pkgmonitor.h
+    src/download/pkgdownloadmanager.h \
+    src/download/pkgdownloadtask.h \
+    src/download/pkgfilecache.h \
+    src/pkgmonitor/pkgmonitor.h \
+    src/stallmonitor/stallmonitor.h \
+    src/search/appsearchindex.h \
+    src/search/appdescindex.h \
+    src/search/fuzzymatcher.h \
+    src/search/asciinametable.h \
+    src/search/appquery.h
 
 isEmpty(VERSION) {
     VERSION = 0.0.1
@@ -77,5 +103,20 @@ INSTALLS += target icon opt_desktop usr_desktop pkg start deepin_pkg_info
 RESOURCES += \
     resources/icons.qrc
 
+# 构建时用tools/pinyintablegen生成汉字拼音表数据（pinyintabledata.h），运行时直接查表
+PINYIN_TABLE_GENERATOR_SOURCES = $$PWD/tools/pinyintablegen/main.cpp
+pinyintablegen.input = PINYIN_TABLE_GENERATOR_SOURCES
+pinyintablegen.output = $$OUT_PWD/pinyintabledata.h
+pinyintablegen.commands = $(MKDIR) $$OUT_PWD/pinyintablegen && \
+    cd $$OUT_PWD/pinyintablegen && \
+    $$QMAKE_QMAKE $$PWD/tools/pinyintablegen/pinyintablegen.pro && \
+    $(MAKE) && \
+    ./pinyintablegen ${QMAKE_FILE_OUT}
+pinyintablegen.depends = $$PWD/tools/pinyintablegen/pinyintablegen.pro $$PWD/src/common/pinyintable.h
+pinyintablegen.variable_out = HEADERS
+pinyintablegen.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += pinyintablegen
+INCLUDEPATH += $$OUT_PWD
+
 LIBS += -L$$PWD/zlib -lz \
     -L$$PWD/ -lgsettings-qt
@@ -0,0 +1,478 @@
+#include "applistmodel.h"
+#include "stallmonitor/stallmonitor.h"
+
+#include <DStyledItemDelegate>
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace AM;
+
+Q_DECLARE_METATYPE(QMargins)
+const QMargins AppListItemMargin(5, 3, 5, 3);
+
+AppListModel::AppListModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_isRowMapDirty(false)
+    , m_sortType(SortByName)
+    , m_isRowListSorted(true)
+    , m_filterType(FilterAll)
+    , m_exposedRowCount(0)
+    , m_exposeTimer(new QTimer(this))
+{
+    m_exposeTimer->setSingleShot(true);
+    m_exposeTimer->setInterval(0);
+    connect(m_exposeTimer, &QTimer::timeout, this, &AppListModel::onExposeTimerTimeout);
+}
+
+AppListModel::~AppListModel()
+{
+}
+
+int AppListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_exposedRowCount;
+}
+
+QVariant AppListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_exposedRowCount) {
+        return QVariant();
+    }
+
+    const AppInfo &appInfo = m_catalogue.at(m_rowList.at(index.row()));
+    switch (role) {
+    case Qt::DisplayRole:
+        return appInfo.desktopInfo.appName.isEmpty() ? appInfo.pkgName : appInfo.desktopInfo.appName;
+    case Qt::DecorationRole:
+        return getIcon(appInfo.desktopInfo.themeIconName);
+    case Dtk::ItemDataRole::MarginsRole:
+        return QVariant::fromValue(AppListItemMargin);
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_ALL_DATA:
+        return QVariant::fromValue(appInfo);
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME:
+        return appInfo.pkgName;
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_APP_NAME:
+        return appInfo.searchKeys.nameSortKey;
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_SIZE:
+        return appInfo.installedPkgInfo.pkgSize;
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_INSTALLED_SIZE:
+        return appInfo.installedPkgInfo.installedSize;
+    case AM_LIST_VIEW_ITEM_DATA_ROLE_UPDATED_TIME:
+        return appInfo.installedPkgInfo.updatedTime;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+void AppListModel::setCatalogue(const QList<AppInfo> &appInfoList)
+{
+    beginResetModel();
+    m_catalogue = appInfoList;
+    m_catalogueIndexMap.clear();
+    m_catalogueIndexMap.reserve(m_catalogue.size());
+    for (int i = 0; i < m_catalogue.size(); ++i) {
+        m_catalogueIndexMap.insert(m_catalogue.at(i).pkgName, i);
+    }
+    m_rowList.clear();
+    m_rowList.reserve(m_catalogue.size());
+    m_rowMap.fill(-1, m_catalogue.size());
+    m_isRowMapDirty = false;
+    clearSortPermutations();
+    for (QBitArray &filterMask : m_filterMasks) {
+        filterMask.fill(false, m_catalogue.size());
+    }
+    m_searchedList.clear();
+    for (int i = 0; i < m_catalogue.size(); ++i) {
+        updateFilterMasks(i);
+    }
+    rebuildRows();
+    resetExposedRows();
+    endResetModel();
+}
+
+const QList<AppInfo> &AppListModel::getCatalogue() const
+{
+    return m_catalogue;
+}
+
+int AppListModel::getCatalogueIndex(const QString &pkgName) const
+{
+    return m_catalogueIndexMap.value(pkgName, -1);
+}
+
+int AppListModel::updateApp(const AppInfo &appInfo)
+{
+    int catalogueIndex = getCatalogueIndex(appInfo.pkgName);
+    if (-1 == catalogueIndex) {
+        catalogueIndex = m_catalogue.size();
+        m_catalogue.append(appInfo);
+        m_catalogueIndexMap.insert(appInfo.pkgName, catalogueIndex);
+        m_rowMap.append(-1);
+        for (QBitArray &filterMask : m_filterMasks) {
+            filterMask.resize(m_catalogue.size());
+        }
+        updateSortPermutations(catalogueIndex, appInfo);
+    } else {
+        const AppInfo oldAppInfo = m_catalogue.at(catalogueIndex);
+        m_catalogue[catalogueIndex] = appInfo;
+        updateSortPermutations(catalogueIndex, oldAppInfo);
+    }
+    updateFilterMasks(catalogueIndex);
+
+    const int row = getRow(catalogueIndex);
+    if (-1 != row) {
+        // 排序关键字可能变化，下次排序时重建行
+        m_isRowListSorted = false;
+        if (row < m_exposedRowCount) {
+            const QModelIndex modelIndex = index(row, 0);
+            Q_EMIT dataChanged(modelIndex, modelIndex);
+        }
+    }
+
+    // 搜索结果只更新数据，其他范围根据变化后的位添加或移除行，全部应用中新追加的应用也需添加
+    if (FilterSearched != m_filterType) {
+        const bool isInRange = (FilterAll == m_filterType) || m_filterMasks[m_filterType].testBit(catalogueIndex);
+        if (isInRange && -1 == row) {
+            const int insertRow = getSortedInsertRow(catalogueIndex);
+            if (insertRow < m_exposedRowCount || m_exposedRowCount == m_rowList.size()) {
+                beginInsertRows(QModelIndex(), insertRow, insertRow);
+                m_rowList.insert(insertRow, catalogueIndex);
+                ++m_exposedRowCount;
+                markRowMapDirty();
+                endInsertRows();
+            } else {
+                // 插入到尚未显示的行中，之后分批显示
+                m_rowList.insert(insertRow, catalogueIndex);
+                markRowMapDirty();
+            }
+        } else if (!isInRange && row >= m_exposedRowCount) {
+            // 尚未显示的行直接移除
+            m_rowList.remove(row);
+            markRowMapDirty();
+        } else if (!isInRange && -1 != row) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_rowList.remove(row);
+            --m_exposedRowCount;
+            markRowMapDirty();
+            endRemoveRows();
+        }
+    }
+    return catalogueIndex;
+}
+
+void AppListModel::setFilter(FilterType filterType)
+{
+    beginResetModel();
+    m_filterType = filterType;
+    rebuildRows();
+    resetExposedRows();
+    endResetModel();
+}
+
+void AppListModel::clearSearched()
+{
+    m_filterMasks[FilterSearched].fill(false);
+    m_searchedList.resize(0);
+    if (FilterSearched == m_filterType && !m_rowList.isEmpty()) {
+        beginResetModel();
+        rebuildRows();
+        resetExposedRows();
+        endResetModel();
+    }
+}
+
+void AppListModel::appendSearched(const QVector<int> &catalogueIndexList)
+{
+    QBitArray &searchedMask = m_filterMasks[FilterSearched];
+    if (FilterSearched != m_filterType) {
+        for (int catalogueIndex : catalogueIndexList) {
+            if (!searchedMask.testBit(catalogueIndex)) {
+                searchedMask.setBit(catalogueIndex);
+                m_searchedList.append(catalogueIndex);
+            }
+        }
+        return;
+    }
+
+    // 结果按匹配等级分批到达，依次追加到列表末尾，已在列表中的不重复添加
+    if (m_isRowMapDirty) {
+        rebuildRowMap();
+    }
+    for (int catalogueIndex : catalogueIndexList) {
+        if (searchedMask.testBit(catalogueIndex)) {
+            continue;
+        }
+        searchedMask.setBit(catalogueIndex);
+        m_searchedList.append(catalogueIndex);
+        // 追加不影响已有行，直接记录新行
+        m_rowMap[catalogueIndex] = m_rowList.size();
+        m_rowList.append(catalogueIndex);
+    }
+
+    // 第一屏立即显示，其余行分批显示
+    exposeRows(APP_LIST_FIRST_SCREEN_ROW_COUNT - m_exposedRowCount);
+    scheduleExposing();
+}
+
+int AppListModel::getRow(int catalogueIndex) const
+{
+    if (0 > catalogueIndex || catalogueIndex >= m_catalogue.size()) {
+        return -1;
+    }
+
+    if (m_isRowMapDirty) {
+        rebuildRowMap();
+    }
+    return m_rowMap.at(catalogueIndex);
+}
+
+int AppListModel::getRowByPkgName(const QString &pkgName) const
+{
+    return getRow(getCatalogueIndex(pkgName));
+}
+
+const AppInfo &AppListModel::getAppInfo(int row) const
+{
+    return m_catalogue.at(m_rowList.at(row));
+}
+
+void AppListModel::sortRows(SortType sortType)
+{
+    if (sortType == m_sortType && m_isRowListSorted) {
+        return;
+    }
+
+    // 搜索结果保持匹配度顺序，只记录排序方式，切换到其他范围时使用
+    m_sortType = sortType;
+    if (FilterSearched == m_filterType) {
+        return;
+    }
+
+    // 行数不变，只重排，已显示的行数保持不变
+    Q_EMIT layoutAboutToBeChanged();
+    // 选中项等持久索引跟随应用移动到新行
+    const QModelIndexList oldIndexList = persistentIndexList();
+    QVector<int> catalogueIndexList;
+    catalogueIndexList.reserve(oldIndexList.size());
+    for (const QModelIndex &oldIndex : oldIndexList) {
+        catalogueIndexList.append(m_rowList.at(oldIndex.row()));
+    }
+
+    rebuildRows();
+
+    QModelIndexList newIndexList;
+    newIndexList.reserve(oldIndexList.size());
+    for (int catalogueIndex : catalogueIndexList) {
+        const int row = getRow(catalogueIndex);
+        // 移到尚未显示的行时视图中不再有该项
+        newIndexList.append((-1 != row && row < m_exposedRowCount) ? index(row, 0) : QModelIndex());
+    }
+    changePersistentIndexList(oldIndexList, newIndexList);
+    Q_EMIT layoutChanged();
+}
+
+void AppListModel::onExposeTimerTimeout()
+{
+    StallSection stallSection(Q_FUNC_INFO);
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    while (m_exposedRowCount < m_rowList.size() && APP_LIST_EXPOSE_TIME_SLICE_MS > elapsedTimer.elapsed()) {
+        exposeRows(APP_LIST_EXPOSE_BATCH_ROW_COUNT);
+    }
+    scheduleExposing();
+}
+
+void AppListModel::resetExposedRows()
+{
+    m_exposedRowCount = qMin(m_rowList.size(), APP_LIST_FIRST_SCREEN_ROW_COUNT);
+    scheduleExposing();
+}
+
+void AppListModel::exposeRows(int count)
+{
+    const int lastRow = qMin(m_rowList.size(), m_exposedRowCount + count) - 1;
+    if (lastRow < m_exposedRowCount) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_exposedRowCount, lastRow);
+    m_exposedRowCount = lastRow + 1;
+    endInsertRows();
+}
+
+void AppListModel::scheduleExposing()
+{
+    if (m_exposedRowCount < m_rowList.size() && !m_exposeTimer->isActive()) {
+        m_exposeTimer->start();
+    }
+}
+
+QIcon AppListModel::getIcon(const QString &themeIconName) const
+{
+    const QString iconName = themeIconName.isEmpty() ? QString(APP_THEME_ICON_DEFAULT) : themeIconName;
+    QHash<QString, QIcon>::const_iterator cIter = m_iconCache.constFind(iconName);
+    if (m_iconCache.cend() != cIter) {
+        return cIter.value();
+    }
+
+    const QIcon icon = QIcon::fromTheme(iconName);
+    m_iconCache.insert(iconName, icon);
+    return icon;
+}
+
+void AppListModel::markRowMapDirty()
+{
+    m_isRowMapDirty = true;
+}
+
+void AppListModel::rebuildRowMap() const
+{
+    m_rowMap.fill(-1, m_catalogue.size());
+    for (int row = 0; row < m_rowList.size(); ++row) {
+        m_rowMap[m_rowList.at(row)] = row;
+    }
+    m_isRowMapDirty = false;
+}
+
+bool AppListModel::isSortedBefore(SortType sortType, const AppInfo &appInfoA, int a, const AppInfo &appInfoB, int b)
+{
+    switch (sortType) {
+    case SortByName: {
+        const int result = appInfoA.searchKeys.nameSortKey.compare(appInfoB.searchKeys.nameSortKey);
+        if (0 != result) {
+            return 0 > result;
+        }
+        break;
+    }
+    case SortByInstalledSize:
+        if (appInfoA.installedPkgInfo.installedSize != appInfoB.installedPkgInfo.installedSize) {
+            return appInfoA.installedPkgInfo.installedSize > appInfoB.installedPkgInfo.installedSize;
+        }
+        break;
+    case SortByUpdatedTime:
+        if (appInfoA.installedPkgInfo.updatedTimestamp != appInfoB.installedPkgInfo.updatedTimestamp) {
+            return appInfoA.installedPkgInfo.updatedTimestamp > appInfoB.installedPkgInfo.updatedTimestamp;
+        }
+        break;
+    case SortTypeCount:
+        break;
+    }
+    return a < b;
+}
+
+const QVector<int> &AppListModel::getSortPermutation(SortType sortType)
+{
+    QVector<int> &permutation = m_sortPermutations[sortType];
+    if (permutation.size() != m_catalogue.size()) {
+        permutation.resize(m_catalogue.size());
+        for (int i = 0; i < permutation.size(); ++i) {
+            permutation[i] = i;
+        }
+        std::sort(permutation.begin(), permutation.end(), [this, sortType](int a, int b) {
+            return isSortedBefore(sortType, m_catalogue.at(a), a, m_catalogue.at(b), b);
+        });
+    }
+    return permutation;
+}
+
+int AppListModel::getSortedInsertRow(int catalogueIndex)
+{
+    // 在当前排序方式的排列中找到该应用，插入到其后第一个已在列表中的应用之前
+    const QVector<int> &permutation = getSortPermutation(m_sortType);
+    const AppInfo &appInfo = m_catalogue.at(catalogueIndex);
+    QVector<int>::const_iterator cIter = std::lower_bound(permutation.cbegin(), permutation.cend(), catalogueIndex,
+                                                          [&](int element, int) {
+        return isSortedBefore(m_sortType, m_catalogue.at(element), element, appInfo, catalogueIndex);
+    });
+    if (permutation.cend() != cIter) {
+        ++cIter;
+    }
+    for (; permutation.cend() != cIter; ++cIter) {
+        const int row = getRow(*cIter);
+        if (-1 != row) {
+            return row;
+        }
+    }
+    return m_rowList.size();
+}
+
+void AppListModel::updateSortPermutations(int catalogueIndex, const AppInfo &oldAppInfo)
+{
+    const AppInfo &newAppInfo = m_catalogue.at(catalogueIndex);
+    for (int i = 0; i < SortTypeCount; ++i) {
+        const SortType sortType = SortType(i);
+        QVector<int> &permutation = m_sortPermutations[sortType];
+        // 未构建的排列在首次使用时整体构建
+        if (permutation.isEmpty()) {
+            continue;
+        }
+
+        // 按旧的排序关键字找到原位置并移除，新追加的应用不在排列中
+        // 目录中该应用已是新信息，比较到它自身时需用旧信息，否则新关键字排在前面时会越过原位置
+        const int oldSize = permutation.size();
+        if (catalogueIndex < oldSize) {
+            QVector<int>::iterator oldIter = std::lower_bound(permutation.begin(), permutation.end(), catalogueIndex,
+                                                              [&](int element, int) {
+                const AppInfo &elementAppInfo = (catalogueIndex == element) ? oldAppInfo : m_catalogue.at(element);
+                return isSortedBefore(sortType, elementAppInfo, element, oldAppInfo, catalogueIndex);
+            });
+            Q_ASSERT(permutation.end() != oldIter && catalogueIndex == *oldIter);
+            if (permutation.end() != oldIter && catalogueIndex == *oldIter) {
+                permutation.erase(oldIter);
+            }
+        }
+
+        QVector<int>::iterator newIter = std::lower_bound(permutation.begin(), permutation.end(), catalogueIndex,
+                                                          [&](int element, int) {
+            return isSortedBefore(sortType, m_catalogue.at(element), element, newAppInfo, catalogueIndex);
+        });
+        permutation.insert(newIter, catalogueIndex);
+        Q_ASSERT(permutation.size() == m_catalogue.size());
+    }
+}
+
+void AppListModel::clearSortPermutations()
+{
+    for (QVector<int> &permutation : m_sortPermutations) {
+        permutation.clear();
+    }
+}
+
+void AppListModel::updateFilterMasks(int catalogueIndex)
+{
+    const AppInfo &appInfo = m_catalogue.at(catalogueIndex);
+    m_filterMasks[FilterInstalled].setBit(catalogueIndex, appInfo.isInstalled);
+    // 有desktop文件
+    m_filterMasks[FilterGui].setBit(catalogueIndex, !appInfo.desktopInfo.desktopPath.isEmpty());
+    m_filterMasks[FilterHeld].setBit(catalogueIndex, appInfo.installedPkgInfo.isHoldVersion);
+}
+
+void AppListModel::rebuildRows()
+{
+    // resize(0)保留容量，重复切换时不再分配内存
+    const QVector<int> &permutation = getSortPermutation(m_sortType);
+    m_rowList.resize(0);
+    if (FilterAll == m_filterType) {
+        m_rowList.append(permutation);
+    } else if (FilterSearched == m_filterType) {
+        // 搜索结果按到达顺序，即匹配度顺序
+        m_rowList.append(m_searchedList);
+    } else {
+        const QBitArray &filterMask = m_filterMasks[m_filterType];
+        for (int catalogueIndex : permutation) {
+            if (filterMask.testBit(catalogueIndex)) {
+                m_rowList.append(catalogueIndex);
+            }
+        }
+    }
+    m_isRowListSorted = true;
+    markRowMapDirty();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "common/appmanagercommon.h"
+
+#include <QAbstractListModel>
+#include <QBitArray>
+#include <QHash>
+#include <QIcon>
+#include <QVector>
+
+class QTimer;
+
+// 重置列表时立即显示的行数，约为一屏
+#define APP_LIST_FIRST_SCREEN_ROW_COUNT 64
+// 每批显示的行数
+#define APP_LIST_EXPOSE_BATCH_ROW_COUNT 256
+// 每次事件循环中显示新行的时间片（毫秒），留出绘制时间，保证界面不阻塞超过一帧
+#define APP_LIST_EXPOSE_TIME_SLICE_MS 10
+
+// 应用列表数据模型
+// 全部应用信息保存为一份目录（catalogue），列表行只记录目录下标，
+// 各角色数据在data()中按需计算，切换显示范围时不复制应用信息
+// 各显示范围用目录下标位图表示，应用变化时只更新对应位，切换范围只更换位图
+// 行较多时，先显示一屏，其余行在之后的事件循环中按时间片分批显示
+class AppListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    // 排序方式
+    enum SortType {
+        SortByName = 0, // 名称升序
+        SortByInstalledSize, // 安装大小降序
+        SortByUpdatedTime, // 更新时间降序
+        SortTypeCount
+    };
+
+    // 过滤方式，即列表显示范围
+    enum FilterType {
+        FilterAll = 0, // 全部应用，不使用位图
+        FilterInstalled, // 已安装
+        FilterGui, // 界面应用
+        FilterHeld, // 已保持版本
+        FilterSearched, // 搜索结果
+        FilterTypeCount
+    };
+
+    explicit AppListModel(QObject *parent = nullptr);
+    virtual ~AppListModel() override;
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // 设置应用目录，同时清空列表
+    void setCatalogue(const QList<AM::AppInfo> &appInfoList);
+    const QList<AM::AppInfo> &getCatalogue() const;
+    // 获取包名对应的目录下标，不存在时返回-1
+    int getCatalogueIndex(const QString &pkgName) const;
+    // 更新目录中的应用信息，不存在时追加，返回目录下标
+    int updateApp(const AM::AppInfo &appInfo);
+
+    // 设置过滤方式，列表按当前排序方式显示位图中的应用
+    void setFilter(FilterType filterType);
+    // 清空搜索结果
+    void clearSearched();
+    // 添加一批搜索结果，当前显示搜索结果时按到达顺序追加到列表末尾
+    void appendSearched(const QVector<int> &catalogueIndexList);
+    // 获取目录下标所在行，不在列表中时返回-1
+    int getRow(int catalogueIndex) const;
+    // 获取包名所在行，不在列表中时返回-1
+    int getRowByPkgName(const QString &pkgName) const;
+
+    // 获取行对应的应用信息
+    const AM::AppInfo &getAppInfo(int row) const;
+
+    // 排序列表，按缓存的排列和当前过滤位图重建行，选中项跟随移动；搜索结果保持匹配度顺序
+    void sortRows(SortType sortType);
+
+private Q_SLOTS:
+    // 在时间片内分批显示剩余行
+    void onExposeTimerTimeout();
+
+private:
+    // 重置模型时调用，只显示第一屏
+    void resetExposedRows();
+    // 再显示最多count行
+    void exposeRows(int count);
+    // 有未显示的行时，在下次事件循环中继续显示
+    void scheduleExposing();
+    QIcon getIcon(const QString &themeIconName) const;
+    // 应用a是否排在b之前，排序关键字相同时按目录下标，保证顺序唯一
+    static bool isSortedBefore(SortType sortType, const AM::AppInfo &appInfoA, int a, const AM::AppInfo &appInfoB, int b);
+    // 获取排序方式对应的目录排列，首次使用时构建
+    const QVector<int> &getSortPermutation(SortType sortType);
+    // 不在列表中的应用按当前排序方式应插入的行
+    int getSortedInsertRow(int catalogueIndex);
+    // 应用信息变化后，调整其在已构建的排列中的位置
+    void updateSortPermutations(int catalogueIndex, const AM::AppInfo &oldAppInfo);
+    void clearSortPermutations();
+    // 根据应用信息更新目录下标在各过滤位图中的位
+    void updateFilterMasks(int catalogueIndex);
+    // 按当前排序方式的排列和过滤位图重建行，不分配内存
+    void rebuildRows();
+    // 行顺序整体变化后，目录下标到行的映射需重建
+    void markRowMapDirty();
+    void rebuildRowMap() const;
+
+private:
+    QList<AM::AppInfo> m_catalogue;
+    QHash<QString, int> m_catalogueIndexMap; // 包名 -> 目录下标
+    QVector<int> m_rowList; // 行 -> 目录下标
+    // 目录下标 -> 行，-1表示不在列表中，追加时直接更新，插入、删除和排序后在下次查找时重建
+    mutable QVector<int> m_rowMap;
+    mutable bool m_isRowMapDirty;
+    mutable QHash<QString, QIcon> m_iconCache; // 图标名称 -> 图标
+
+    // 各排序方式下整个目录的排列，变化时通过二分查找移动单个下标
+    QVector<int> m_sortPermutations[SortTypeCount]; // 排序位置 -> 目录下标
+    SortType m_sortType;
+    bool m_isRowListSorted; // 行是否按当前排序方式排列，应用的排序关键字变化后不再有序
+
+    QBitArray m_filterMasks[FilterTypeCount]; // 目录下标 -> 是否属于该显示范围
+    QVector<int> m_searchedList; // 搜索结果的目录下标，按匹配度顺序
+    FilterType m_filterType;
+
+    int m_exposedRowCount; // 已显示的行数，m_rowList中之后的行尚未通知视图
+    QTimer *m_exposeTimer;
+};
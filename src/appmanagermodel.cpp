@@ -12,6 +12,8 @@ AppManagerModel::AppManagerModel(QObject *parent)
     : QObject(parent)
     , m_appManagerJob(nullptr)
     , m_appManagerJobThread(nullptr)
+    , m_appSearchJob(nullptr)
+    , m_appSearchJobThread(nullptr)
 {
     initData();
     initConnection();
@@ -20,12 +22,18 @@ AppManagerModel::AppManagerModel(QObject *parent)
 
 AppManagerModel::~AppManagerModel()
 {
+    // 任务在各自线程结束时析构（连接了QThread::finished），搜索任务使用应用任务，先结束
+    m_appSearchJobThread->quit();
+    m_appSearchJobThread->wait();
+    delete m_appSearchJobThread;
+    m_appSearchJobThread = nullptr;
+    m_appSearchJob = nullptr;
+
+    // 应用任务析构时中止下载并保存续传状态
     m_appManagerJobThread->quit();
     m_appManagerJobThread->wait();
-    m_appManagerJobThread->deleteLater();
+    delete m_appManagerJobThread;
     m_appManagerJobThread = nullptr;
-
-    m_appManagerJob->deleteLater();
     m_appManagerJob = nullptr;
 }
 
@@ -70,7 +78,25 @@ QString AppManagerModel::formatePkgInfo(const PkgInfo &info)
 
 QList<AppInfo> AppManagerModel::getSearchedAppInfoList() const
 {
-    return m_appManagerJob->getSearchedAppInfoList();
+    return m_appSearchJob->getSearchedAppInfoList();
+}
+
+void AppManagerModel::startSearchTask(const QString &text)
+{
+    const int searchId = m_appSearchJob->createSearchId();
+    Q_EMIT notifyThreadStartSearchTask(searchId, text);
+}
+
+int AppManagerModel::startDownloadPkgFile(const PkgInfo &info)
+{
+    const int downloadId = m_appManagerJob->createDownloadId();
+    Q_EMIT notifyThreadDownloadPkgFile(downloadId, info);
+    return downloadId;
+}
+
+void AppManagerModel::cancelPkgFileDownload(int downloadId)
+{
+    Q_EMIT notifyThreadCancelPkgFileDownload(downloadId);
 }
 
 void AppManagerModel::openStoreAppDetailPage(const QString &pkgName)
@@ -169,6 +195,14 @@ bool AppManagerModel::extendPkgInfo(PkgInfo &pkgInfo)
             pkgInfo.pkgSize = infoLine.split(": ").last().toInt();
             continue;
         }
+        if (infoLine.startsWith("SHA256: ")) {
+            pkgInfo.sha256 = infoLine.split(": ").last();
+            continue;
+        }
+        if (infoLine.startsWith("MD5sum: ")) {
+            pkgInfo.md5sum = infoLine.split(": ").last();
+            continue;
+        }
 
         if (infoLine.startsWith("Homepage: ")) {
             pkgInfo.homepage = infoLine.split(": ").last();
@@ -285,6 +319,11 @@ void AppManagerModel::initData()
     m_appManagerJob = new AppManagerJob;
     m_appManagerJob->moveToThread(m_appManagerJobThread);
 
+    // 搜索线程
+    m_appSearchJobThread = new QThread;
+    m_appSearchJob = new AppSearchJob(m_appManagerJob);
+    m_appSearchJob->moveToThread(m_appSearchJobThread);
+
     readOsInfo();
 }
 
@@ -294,22 +333,38 @@ void AppManagerModel::initConnection()
     connect(m_appManagerJob, &AppManagerJob::runningStatusChanged, this, &AppManagerModel::runningStatusChanged);
 
     connect(m_appManagerJobThread, &QThread::started, m_appManagerJob, &AppManagerJob::init);
+    // 线程停止后不再处理延后删除事件，需在线程结束前删除
+    connect(m_appManagerJobThread, &QThread::finished, m_appManagerJob, &QObject::deleteLater);
     connect(this, &AppManagerModel::notifyThreadreloadAppInfos, m_appManagerJob, &AppManagerJob::reloadAppInfos);
     connect(this, &AppManagerModel::notifyThreadDownloadPkgFile, m_appManagerJob, &AppManagerJob::downloadPkgFile);
-    connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadProgressChanged, this, [this](const PkgInfo &info, qint64 bytesRead, qint64 totalBytes) {
-        Q_EMIT this->pkgFileDownloadProgressChanged(info, bytesRead, totalBytes);
+    connect(this, &AppManagerModel::notifyThreadCancelPkgFileDownload, m_appManagerJob, &AppManagerJob::cancelPkgFileDownload);
+    connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadProgressChanged, this, [this](int downloadId, const PkgInfo &info, qint64 bytesRead, qint64 totalBytes) {
+        Q_EMIT this->pkgFileDownloadProgressChanged(downloadId, info, bytesRead, totalBytes);
     });
-    connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadFinished, this, [this](const PkgInfo &info) {
-        Q_EMIT this->pkgFileDownloadFinished(info);
+    connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadFinished, this, [this](int downloadId, const PkgInfo &info) {
+        Q_EMIT this->pkgFileDownloadFinished(downloadId, info);
     });
     connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadFailed, this, &AppManagerModel::pkgFileDownloadFailed);
+    connect(m_appManagerJob, &AppManagerJob::pkgFileDownloadCanceled, this, &AppManagerModel::pkgFileDownloadCanceled);
     connect(m_appManagerJob, &AppManagerJob::loadAppInfosFinished, this, [this] {
         Q_EMIT this->loadAppInfosFinished();
     });
 
-    connect(this, &AppManagerModel::notifyThreadStartSearchTask, m_appManagerJob, &AppManagerJob::startSearchTask);
-    connect(m_appManagerJob, &AppManagerJob::searchTaskFinished, this, [this]() {
-        Q_EMIT this->searchTaskFinished();
+    connect(m_appSearchJobThread, &QThread::started, m_appSearchJob, &AppSearchJob::init);
+    connect(m_appSearchJobThread, &QThread::finished, m_appSearchJob, &QObject::deleteLater);
+    connect(this, &AppManagerModel::notifyThreadStartSearchTask, m_appSearchJob, &AppSearchJob::startSearchTask);
+    // 只转发最新一次搜索的结果
+    connect(m_appSearchJob, &AppSearchJob::searchResultsFound, this, [this](int searchId, const QList<AM::AppInfo> &appInfoList) {
+        if (m_appSearchJob->isSearchCancelled(searchId)) {
+            return;
+        }
+        Q_EMIT this->searchResultsFound(searchId, appInfoList);
+    });
+    connect(m_appSearchJob, &AppSearchJob::searchTaskFinished, this, [this](int searchId) {
+        if (m_appSearchJob->isSearchCancelled(searchId)) {
+            return;
+        }
+        Q_EMIT this->searchTaskFinished(searchId);
     });
 
     connect(this, &AppManagerModel::notifyThreadUninstallPkg, m_appManagerJob, &AppManagerJob::uninstallPkg);
@@ -339,6 +394,7 @@ void AppManagerModel::postInit()
 {
     // 启动线程
     m_appManagerJobThread->start();
+    m_appSearchJobThread->start();
 }
 
 void AppManagerModel::readOsInfo()
@@ -2,6 +2,7 @@
 
 #include "common/appmanagercommon.h"
 #include "job/appmanagerjob.h"
+#include "job/appsearchjob.h"
 
 #include <DSysInfo>
 
@@ -30,16 +31,22 @@ public:
     RunningStatus getRunningStatus();
 
     QList<AM::AppInfo> getAppInfosList();
-    QString formatePkgInfo(const AM::PkgInfo &info);
+    static QString formatePkgInfo(const AM::PkgInfo &info);
 
     QList<AM::AppInfo> getSearchedAppInfoList() const;
+    // 开始搜索，并取消正在进行的搜索
+    void startSearchTask(const QString &text);
 
     void openStoreAppDetailPage(const QString &pkgName);
     void openSpkStoreAppDetailPage(const QString &pkgName);
     QString getDownloadDirPath() const;
     QString getPkgBuildDirPath() const;
-    // 拓展包信息
-    bool extendPkgInfo(AM::PkgInfo &pkgInfo);
+    // 开始下载安装包文件，返回下载编号
+    int startDownloadPkgFile(const AM::PkgInfo &info);
+    // 取消下载
+    void cancelPkgFileDownload(int downloadId);
+    // 拓展包信息，只读取包信息文件，可在工作线程中调用
+    static bool extendPkgInfo(AM::PkgInfo &pkgInfo);
     // 软件包是否已安装
     bool isPkgInstalled(const QString &pkgName);
     // 获取应用信息
@@ -54,13 +61,17 @@ Q_SIGNALS:
 
     void notifyThreadreloadAppInfos();
     void loadAppInfosFinished();
-    void notifyThreadDownloadPkgFile(const PkgInfo &info);
-    void pkgFileDownloadProgressChanged(const PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
-    void pkgFileDownloadFinished(const PkgInfo &info);
-    void pkgFileDownloadFailed(const PkgInfo &info);
-    void notifyThreadStartSearchTask(const QString &text);
+    void notifyThreadDownloadPkgFile(int downloadId, const PkgInfo &info);
+    void notifyThreadCancelPkgFileDownload(int downloadId);
+    void pkgFileDownloadProgressChanged(int downloadId, const PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
+    void pkgFileDownloadFinished(int downloadId, const PkgInfo &info);
+    void pkgFileDownloadFailed(int downloadId, const PkgInfo &info);
+    void pkgFileDownloadCanceled(int downloadId, const PkgInfo &info);
+    void notifyThreadStartSearchTask(int searchId, const QString &text);
+    // 找到一批搜索结果
+    void searchResultsFound(int searchId, const QList<AM::AppInfo> &appInfoList);
     // 搜索任务完成
-    void searchTaskFinished();
+    void searchTaskFinished(int searchId);
     // 通知卸载包
     void notifyThreadUninstallPkg(const QString &pkgName);
     // 通知构建安装包
@@ -95,5 +106,7 @@ private:
 private:
     AppManagerJob *m_appManagerJob;
     QThread *m_appManagerJobThread;
+    AppSearchJob *m_appSearchJob;
+    QThread *m_appSearchJobThread;
     QString m_osId;
 };
@@ -1,5 +1,6 @@
 #include "appmanagerwidget.h"
 #include "dlg/pkgdownloaddlg.h"
+#include "stallmonitor/stallmonitor.h"
 
 #include <DTitlebar>
 #include <DListView>
@@ -16,6 +17,9 @@
 #include <QLineEdit>
 #include <QHBoxLayout>
 #include <QTextEdit>
+#include <QTreeView>
+#include <QScrollBar>
+#include <QAbstractTextDocumentLayout>
 #include <QFile>
 #include <QSettings>
 #include <QTextCodec>
@@ -26,12 +30,11 @@
 #include <QThread>
 #include <QDesktopServices>
 #include <QSplitter>
+#include <QtConcurrent>
 
-using namespace AM;
+#include <algorithm>
 
-Q_DECLARE_METATYPE(QMargins)
-const QMargins ListViewItemMargin(5, 3, 5, 3);
-const QVariant ListViewItemMarginVar = QVariant::fromValue(ListViewItemMargin);
+using namespace AM;
 
 // 高亮文字背景颜色
 const QColor HighlightTextBgColor(255, 255, 0, 190);
@@ -40,10 +43,14 @@ const QColor LocatedHighlightTextBgColor(0, 0, 255, 120);
 
 AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     : QWidget(parent)
+    , m_appDetailWatcher(nullptr)
+    , m_appDetailRequestId(0)
+    , m_isAppDetailRequestPending(false)
     , m_model(model)
     , m_waitingSpinner(nullptr)
     , m_contentWidget(nullptr)
     , m_searchLineEdit(nullptr)
+    , m_showingSearchId(0)
     , m_filterMenu(nullptr)
     , m_showAllAppAction(nullptr)
     , m_showInstalledAppAction(nullptr)
@@ -66,8 +73,15 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     , m_filesBtn(nullptr)
     , m_infoSwitchBtn(nullptr)
     , m_findLineEdit(nullptr)
+    , m_textMatchWatcher(nullptr)
+    , m_textMatchRequestId(0)
+    , m_matchLength(0)
+    , m_currentMatchIndex(-1)
     , m_appInfoTextEdit(nullptr)
-    , m_appFileListTextEdit(nullptr)
+    , m_fileListModel(nullptr)
+    , m_fileMatchWatcher(nullptr)
+    , m_fileMatchRequestId(0)
+    , m_appFileListView(nullptr)
 {
     setFocusPolicy(Qt::FocusPolicy::ClickFocus);
 
@@ -115,6 +129,7 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     m_searchLineEdit = new QLineEdit(this);
     m_searchLineEdit->setPlaceholderText("搜索");
     m_searchLineEdit->setClearButtonEnabled(true);
+    m_searchLineEdit->setToolTip("支持过滤条件，如：installed:yes arch:i386 size>500M repo:spark held:yes gui:");
     guideOperatingLayout->addWidget(m_searchLineEdit);
 
     QPushButton *filterBtn = new QPushButton(this);
@@ -159,7 +174,7 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     m_currentSortingAction = m_descendingSortByNameAction;
 
     // 应用列表
-    m_appListModel = new QStandardItemModel(this);
+    m_appListModel = new AppListModel(this);
 
     m_appListView = new DListView(this);
     m_appListView->setSpacing(0);
@@ -170,6 +185,8 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     m_appListView->setEditTriggers(DListView::EditTrigger::NoEditTriggers);
     m_appListView->setAutoFillBackground(true);
     m_appListView->setItemSize(QSize(80, 48));
+    // 各行大小相同，新增行时不需逐行计算大小
+    m_appListView->setUniformItemSizes(true);
     m_appListView->setModel(m_appListModel);
     leftGuideLayout->addWidget(m_appListView, 1);
 
@@ -275,6 +292,14 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     findNextContentBtn->setIconSize(QSize(30, 30));
     findNextContentBtn->setEnabledCircle(true);
     findContentFrameLayout->addWidget(findNextContentBtn);
+    // 查找上一个按钮
+    DIconButton *findPreviousContentBtn = new DIconButton(this);
+    findPreviousContentBtn->setToolTip("查找上一个");
+    findPreviousContentBtn->setIcon(QIcon(":/actions/chevron-up_48px.svg"));
+    findPreviousContentBtn->setFixedSize(30, 30);
+    findPreviousContentBtn->setIconSize(QSize(30, 30));
+    findPreviousContentBtn->setEnabledCircle(true);
+    findContentFrameLayout->addWidget(findPreviousContentBtn);
     // 取消搜索按钮
     DIconButton *cancelSearchBtn = new DIconButton(this);
     cancelSearchBtn->setToolTip("取消查找");
@@ -292,13 +317,19 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     DApplicationHelper::instance()->setPalette(m_appInfoTextEdit, pa);
     infoFrameLayout->addWidget(m_appInfoTextEdit);
 
-    m_appFileListTextEdit = new QTextEdit(this);
-    m_appFileListTextEdit->setLineWidth(0);
-    m_appFileListTextEdit->setReadOnly(true);
-    pa = DApplicationHelper::instance()->palette(m_appFileListTextEdit);
+    // 文件列表按目录分组显示，展开时才生成子项
+    m_fileListModel = new FileListModel(this);
+    m_appFileListView = new QTreeView(this);
+    m_appFileListView->setFrameShape(QFrame::Shape::NoFrame);
+    m_appFileListView->setHeaderHidden(true);
+    m_appFileListView->setUniformRowHeights(true);
+    m_appFileListView->setEditTriggers(QTreeView::EditTrigger::NoEditTriggers);
+    m_appFileListView->setTextElideMode(Qt::TextElideMode::ElideMiddle);
+    m_appFileListView->setModel(m_fileListModel);
+    pa = DApplicationHelper::instance()->palette(m_appFileListView);
     pa.setColor(DPalette::ColorRole::Base, Qt::transparent);
-    DApplicationHelper::instance()->setPalette(m_appFileListTextEdit, pa);
-    infoFrameLayout->addWidget(m_appFileListTextEdit);
+    DApplicationHelper::instance()->setPalette(m_appFileListView, pa);
+    infoFrameLayout->addWidget(m_appFileListView);
 
     // 信息展示去底部第一行
     infoFrameLayout->addSpacing(5);
@@ -355,8 +386,8 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     infoFrameLayout->addSpacing(10);
 
     // connection
-    // 搜索框
-    connect(m_searchLineEdit, &QLineEdit::editingFinished, this, &AppManagerWidget::onSearchEditingFinished);
+    // 搜索框，边输入边搜索
+    connect(m_searchLineEdit, &QLineEdit::textChanged, this, &AppManagerWidget::onSearchTextChanged);
 
     // 过滤菜单
     connect(filterBtn, &QPushButton::pressed, this, [=] {
@@ -403,7 +434,7 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
 
     connect(m_appListView, &DListView::clicked, this, [this](const QModelIndex &index) {
         int row = index.row();
-        if (row > (m_appInfoList.size() - 1)) {
+        if (row > (m_appListModel->rowCount() - 1)) {
             qDebug() << Q_FUNC_INFO << "列表越界";
             return;
         }
@@ -438,13 +469,25 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
     });
 
     connect(m_findLineEdit, &QLineEdit::editingFinished, this, &AppManagerWidget::updateHighlightText);
+    connect(m_findLineEdit, &QLineEdit::editingFinished, this, &AppManagerWidget::updateFileMatches);
     connect(findNextContentBtn, &DIconButton::clicked, this, &AppManagerWidget::moveToNextHighlightText);
+    connect(findPreviousContentBtn, &DIconButton::clicked, this, &AppManagerWidget::moveToPreviousHighlightText);
+    // 信息文本变化后重新查找，滚动或重新布局后更新可见区域的高亮
+    m_textMatchWatcher = new QFutureWatcher<TextMatchResult>(this);
+    connect(m_textMatchWatcher, &QFutureWatcher<TextMatchResult>::finished, this, &AppManagerWidget::onTextMatchFinished);
+    m_fileMatchWatcher = new QFutureWatcher<FileMatchResult>(this);
+    connect(m_fileMatchWatcher, &QFutureWatcher<FileMatchResult>::finished, this, &AppManagerWidget::onFileMatchFinished);
+    connect(m_appInfoTextEdit, &QTextEdit::textChanged, this, &AppManagerWidget::updateHighlightText);
+    connect(m_appInfoTextEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &AppManagerWidget::updateVisibleHighlight);
+    connect(m_appInfoTextEdit->document()->documentLayout(), &QAbstractTextDocumentLayout::documentSizeChanged,
+            this, &AppManagerWidget::updateVisibleHighlight);
     connect(cancelSearchBtn, &DIconButton::clicked, this, [findContentFrame, openFindToolBtn, this] {
         findContentFrame->setVisible(false);
         openFindToolBtn->setDown(false);
         // 清空文本搜索内容
         m_findLineEdit->setText("");
         this->updateHighlightText();
+        this->updateFileMatches();
     });
 
     // 卸载
@@ -545,14 +588,23 @@ AppManagerWidget::AppManagerWidget(AppManagerModel *model, QWidget *parent)
         dlg = nullptr;
     });
 
+    // 应用详情加载
+    m_appDetailWatcher = new QFutureWatcher<AppDetail>(this);
+    connect(m_appDetailWatcher, &QFutureWatcher<AppDetail>::finished, this, &AppManagerWidget::onAppDetailLoaded);
+
     // model信号连接
     connect(m_model, &AppManagerModel::loadAppInfosFinished, this, [this] {
-        m_appInfoList = m_model->getAppInfosList();
+        StallSection stallSection(Q_FUNC_INFO);
+        m_appListModel->setCatalogue(m_model->getAppInfosList());
         // 默认显示界面应用
         Q_EMIT m_filterMenu->triggered(m_showGuiAppAction);
         this->setLoading(false);
     });
 
+    // 列表行分批显示，随之更新应用个数
+    connect(m_appListModel, &AppListModel::rowsInserted, this, &AppManagerWidget::updateAppCountLabel);
+
+    connect(m_model, &AppManagerModel::searchResultsFound, this, &AppManagerWidget::onSearchResultsFound);
     connect(m_model, &AppManagerModel::searchTaskFinished, this, &AppManagerWidget::onSearchTaskFinished);
 
     // 包安装变动
@@ -571,21 +623,9 @@ AppManagerWidget::~AppManagerWidget()
 
 void AppManagerWidget::showAppInfo(const AppInfo &info)
 {
+    StallSection stallSection(Q_FUNC_INFO);
     m_showingAppInfo = info;
-
-    // 拓展仓库应用信息
-    for (PkgInfo &srvPkgInfo : m_showingAppInfo.pkgInfoList) {
-        if (!m_model->extendPkgInfo(srvPkgInfo)) {
-            continue;
-        }
-
-        // 根据版本找到候选包中对应的包大小和下载地址
-        if (m_showingAppInfo.installedPkgInfo.version == srvPkgInfo.version
-                && m_showingAppInfo.installedPkgInfo.arch == srvPkgInfo.arch) {
-            m_showingAppInfo.installedPkgInfo.pkgSize = srvPkgInfo.pkgSize;
-            m_showingAppInfo.installedPkgInfo.downloadUrl = srvPkgInfo.downloadUrl;
-        }
-    }
+    ++m_appDetailRequestId;
 
     const QString themeIconName = m_showingAppInfo.desktopInfo.themeIconName;
     if (!themeIconName.isEmpty()) {
@@ -607,273 +647,91 @@ void AppManagerWidget::showAppInfo(const AppInfo &info)
 
     m_infoBtn->setChecked(true);
 
-    m_appInfoTextEdit->setText(formateAppInfo(m_showingAppInfo));
+    // 先显示本地信息，仓库安装包信息在工作线程中读取后再显示，文件列表同时在工作线程中排序
+    // 没有仓库安装包信息时无需加载，不显示加载中
+    const bool hasNoRepoPkgInfo = m_showingAppInfo.pkgInfoList.isEmpty();
+    m_appInfoTextEdit->setText(formateAppInfo(m_showingAppInfo, hasNoRepoPkgInfo));
     m_appInfoTextEdit->show();
-    m_appFileListTextEdit->hide();
+    m_appFileListView->hide();
+    if (!hasNoRepoPkgInfo || !m_showingAppInfo.installedPkgInfo.installedFileList.isEmpty()) {
+        requestAppDetail();
+    }
 }
 
 void AppManagerWidget::showAppFileList(const AppInfo &info)
 {
+    StallSection stallSection(Q_FUNC_INFO);
     Q_UNUSED(info);
     m_filesBtn->setChecked(true);
 
     m_appInfoTextEdit->hide();
-    QString fileListText;
-    for (const QString &filePath : m_showingAppInfo.installedPkgInfo.installedFileList) {
-        fileListText += QString("%1\n").arg(filePath);
-    }
-    m_appFileListTextEdit->setText(fileListText);
-    m_appFileListTextEdit->show();
+    m_fileListModel->setFilePathList(m_showingAppInfo.installedPkgInfo.installedFileList);
+    updateFileMatches();
+    m_appFileListView->show();
 }
 
-void AppManagerWidget::onSearchEditingFinished()
+void AppManagerWidget::onSearchTextChanged(const QString &text)
 {
-    this->setFocus();
-    QString inputText = m_searchLineEdit->text();
-    Q_EMIT m_model->notifyThreadStartSearchTask(inputText);
+    // 每次输入都开始新的搜索，并取消正在进行的搜索
+    m_model->startSearchTask(text);
 }
 
-void AppManagerWidget::onSearchTaskFinished()
+void AppManagerWidget::onSearchResultsFound(int searchId, const QList<AM::AppInfo> &appInfoList)
 {
-    // 显示搜索的应用
-    Q_EMIT m_filterMenu->triggered(m_showSearchedAppAction);
-}
-
-void AppManagerWidget::onAppInstalled(const AM::AppInfo &appInfo)
-{
-    for (QList<AppInfo>::iterator iter = m_appInfoList.begin();
-         iter != m_appInfoList.end(); ++iter) {
-        if (appInfo.pkgName == iter->pkgName) {
-            *iter = appInfo;
-            break;
+    StallSection stallSection(Q_FUNC_INFO);
+    if (searchId != m_showingSearchId) {
+        // 新搜索的第一批结果，切换到搜索结果并替换列表
+        m_showingSearchId = searchId;
+        m_displayRangeType = Searched;
+        for (QAction *action : m_filterMenu->actions()) {
+            action->setChecked(m_showSearchedAppAction == action);
         }
+        m_appListModel->clearSearched();
+        m_appListModel->setFilter(AppListModel::FilterSearched);
     }
 
-    switch (m_displayRangeType) {
-    case All:
-    case Searched: {
-        // 更新界面数据
-        for (int i = 0; i < m_appListModel->rowCount(); ++i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            if (appInfo.pkgName == item->data(AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME).toString()) {
-                updateItemFromAppInfo(item, appInfo);
-                break;
-            }
-        }
-        break;
-    }
-    case Installed: {
-        m_appListModel->insertRow(0, createViewItemList(appInfo));
-        break;
-    }
-    case Gui: {
-        // 有desktop文件
-        if (!appInfo.desktopInfo.desktopPath.isEmpty()) {
-            m_appListModel->insertRow(0, createViewItemList(appInfo));
-        }
-        break;
-    }
-    case VerHeld:
-        if (appInfo.installedPkgInfo.isHoldVersion) {
-            m_appListModel->insertRow(0, createViewItemList(appInfo));
+    // 搜索过程中切换到其他类别时，结果只记录在搜索结果位图中
+    QVector<int> catalogueIndexList;
+    for (const AppInfo &info : appInfoList) {
+        const int catalogueIndex = m_appListModel->getCatalogueIndex(info.pkgName);
+        if (-1 != catalogueIndex) {
+            catalogueIndexList.append(catalogueIndex);
         }
-        break;
     }
+    m_appListModel->appendSearched(catalogueIndexList);
 
-    // 刷新右侧显示内容
-    if (appInfo.pkgName == m_showingAppInfo.pkgName) {
-        // 更改后，显示列表当前选中应用
-        AppInfo currentAppInfo = getAppInfoFromListViewModelByPkgName(m_showingAppInfo.pkgName);
-        showAppInfo(currentAppInfo);
-    }
     // 更新应用个数标签
     updateAppCountLabel();
 }
 
-void AppManagerWidget::onAppUpdated(const AM::AppInfo &appInfo)
+void AppManagerWidget::onSearchTaskFinished(int searchId)
 {
-    for (QList<AppInfo>::iterator iter = m_appInfoList.begin();
-         iter != m_appInfoList.end(); ++iter) {
-        if (appInfo.pkgName == iter->pkgName) {
-            *iter = appInfo;
-            break;
-        }
-    }
-
-    switch (m_displayRangeType) {
-    case All:
-    case Searched:
-    case Installed: {
-        // 更新界面数据
-        for (int i = 0; i < m_appListModel->rowCount(); ++i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            if (appInfo.pkgName == item->data(AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME).toString()) {
-                updateItemFromAppInfo(item, appInfo);
-                break;
-            }
-        }
-        break;
-    }
-    case Gui: {
-        int operateType = 0; // 0 - none, 1 - add, 2 - remove, 3 - update
-        bool isInList = false;
-        for (int i = m_appListModel->rowCount() - 1; i >= 0 ; --i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            AppInfo inListAppInfo = getAppInfoFromModelIndex(item->index());
-            if (appInfo.pkgName != inListAppInfo.pkgName) {
-                continue;
-            }
-            isInList = true;
-
-            if (appInfo.desktopInfo.desktopPath.isEmpty()) {
-                operateType = 2;
-            } else {
-                operateType = 3;
-            }
-            break;
-        }
-        // 不在gui列表中，并存在desktop信息，则为添加操作
-        if (!isInList && !appInfo.desktopInfo.desktopPath.isEmpty()) {
-            operateType = 1;
-        }
-        // 如果不需要操作
-        if (0 == operateType) {
-            break;
-        }
-
-        // 根据操作类型，更新界面和缓存列表
-        if (1 == operateType) {
-            m_appListModel->insertRow(0, createViewItemList(appInfo));
-        } else {
-            for (int i = m_appListModel->rowCount() - 1; i >= 0 ; --i) {
-                QStandardItem *item = m_appListModel->item(i, 0);
-                AppInfo inListAppInfo = getAppInfoFromModelIndex(item->index());
-                if (appInfo.pkgName != inListAppInfo.pkgName) {
-                    continue;
-                }
-
-                if (2 == operateType) {
-                    m_appListModel->removeRow(i);
-                } else if (3 == operateType) {
-                    updateItemFromAppInfo(item, appInfo);
-                }
-                break;
-            }
-        }
-
-        break;
+    if (searchId != m_showingSearchId) {
+        // 没有找到任何结果，显示空的搜索结果
+        m_showingSearchId = searchId;
+        m_appListModel->clearSearched();
+        Q_EMIT m_filterMenu->triggered(m_showSearchedAppAction);
     }
-    case VerHeld: {
-        int operateType = 0; // 0 - none, 1 - add, 2 - remove, 3 - update
-        bool isInList = false;
-        for (int i = m_appListModel->rowCount() - 1; i >= 0 ; --i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            AppInfo inListAppInfo = getAppInfoFromModelIndex(item->index());
-            if (appInfo.pkgName != inListAppInfo.pkgName) {
-                continue;
-            }
-            isInList = true;
-
-            if (!appInfo.installedPkgInfo.isHoldVersion) {
-                operateType = 2;
-            } else {
-                operateType = 3;
-            }
-            break;
-        }
-        // 不在held列表中，并为保持版本，则为添加操作
-        if (!isInList && appInfo.installedPkgInfo.isHoldVersion) {
-            operateType = 1;
-        }
-        // 如果不需要操作
-        if (0 == operateType) {
-            break;
-        }
-
-        // 根据操作类型，更新界面和缓存列表
-        if (1 == operateType) {
-            m_appListModel->insertRow(0, createViewItemList(appInfo));
-        } else {
-            for (int i = m_appListModel->rowCount() - 1; i >= 0 ; --i) {
-                QStandardItem *item = m_appListModel->item(i, 0);
-                AppInfo inListAppInfo = getAppInfoFromModelIndex(item->index());
-                if (appInfo.pkgName != inListAppInfo.pkgName) {
-                    continue;
-                }
-
-                if (2 == operateType) {
-                    m_appListModel->removeRow(i);
-                } else if (3 == operateType) {
-                    updateItemFromAppInfo(item, appInfo);
-                }
-                break;
-            }
-        }
+}
 
-        break;
-    }
-    }
+void AppManagerWidget::onAppInstalled(const AM::AppInfo &appInfo)
+{
+    updateAppInList(appInfo);
+}
 
-    // 刷新右侧显示内容
-    if (appInfo.pkgName == m_showingAppInfo.pkgName) {
-        // 更改后，显示列表当前选中应用
-        AppInfo currentAppInfo = getAppInfoFromListViewModelByPkgName(m_showingAppInfo.pkgName);
-        showAppInfo(currentAppInfo);
-    }
-    // 更新应用个数标签
-    updateAppCountLabel();
+void AppManagerWidget::onAppUpdated(const AM::AppInfo &appInfo)
+{
+    updateAppInList(appInfo);
 }
 
 void AppManagerWidget::onAppUninstalled(const AM::AppInfo &appInfo)
 {
-    for (QList<AppInfo>::iterator iter = m_appInfoList.begin();
-         iter != m_appInfoList.end(); ++iter) {
-        if (appInfo.pkgName == iter->pkgName) {
-            *iter = appInfo;
-            break;
-        }
-    }
-
-    switch (m_displayRangeType) {
-    case All:
-    case Searched: {
-        // 更新界面数据
-        for (int i = 0; i < m_appListModel->rowCount(); ++i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            if (appInfo.pkgName == item->data(AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME).toString()) {
-                updateItemFromAppInfo(item, appInfo);
-                break;
-            }
-        }
-        break;
-    }
-    case Installed:
-    case Gui:
-    case VerHeld: {
-        // 更新界面数据
-        for (int i = m_appListModel->rowCount() - 1; i >= 0 ; --i) {
-            QStandardItem *item = m_appListModel->item(i, 0);
-            if (appInfo.pkgName == item->data(AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME).toString()) {
-                m_appListModel->removeRow(i);
-                break;
-            }
-        }
-        break;
-    }
-    }
-
-    // 刷新右侧显示内容
-    if (appInfo.pkgName == m_showingAppInfo.pkgName) {
-        // 删除后，显示列表当前选中应用
-        AppInfo currentAppInfo = getAppInfoFromListViewModelByPkgName(m_showingAppInfo.pkgName);
-        showAppInfo(currentAppInfo);
-    }
-    // 更新应用个数标签
-    updateAppCountLabel();
+    updateAppInList(appInfo);
 }
 
 void AppManagerWidget::onSorterMenuTriggered(QAction *action)
 {
+    StallSection stallSection(Q_FUNC_INFO);
     m_descendingSortByNameAction->setChecked(false);
     m_descendingSortByInstalledSizeAction->setChecked(false);
     m_descendingSortByUpdatedTimeAction->setChecked(false);
@@ -881,14 +739,11 @@ void AppManagerWidget::onSorterMenuTriggered(QAction *action)
     action->setChecked(true);
     m_currentSortingAction = action;
     if (m_descendingSortByNameAction == action) {
-        m_appListModel->setSortRole(AM_LIST_VIEW_ITEM_DATA_ROLE_APP_NAME);
-        m_appListModel->sort(0, Qt::SortOrder::AscendingOrder);
+        m_appListModel->sortRows(AppListModel::SortByName);
     } else if (m_descendingSortByInstalledSizeAction == action) {
-        m_appListModel->setSortRole(AM_LIST_VIEW_ITEM_DATA_ROLE_INSTALLED_SIZE);
-        m_appListModel->sort(0, Qt::SortOrder::DescendingOrder);
+        m_appListModel->sortRows(AppListModel::SortByInstalledSize);
     } else if (m_descendingSortByUpdatedTimeAction == action) {
-        m_appListModel->setSortRole(AM_LIST_VIEW_ITEM_DATA_ROLE_UPDATED_TIME);
-        m_appListModel->sort(0, Qt::SortOrder::DescendingOrder);
+        m_appListModel->sortRows(AppListModel::SortByUpdatedTime);
     }
 
     if (m_appListModel->rowCount()) {
@@ -902,7 +757,7 @@ void AppManagerWidget::onSorterMenuTriggered(QAction *action)
     }
 }
 
-QString AppManagerWidget::formateAppInfo(const AppInfo &info)
+QString AppManagerWidget::formateAppInfo(const AppInfo &info, bool isRepoPkgInfoReady)
 {
     QString text;
     // 本地安装包信息
@@ -934,23 +789,76 @@ QString AppManagerWidget::formateAppInfo(const AppInfo &info)
     // 仓库安装包信息
     text += "仓库安装包信息\n"
             "-----------------------------\n";
+    if (!isRepoPkgInfoReady) {
+        text += "(加载中...)\n";
+        return text;
+    }
     for (const PkgInfo &pkgInfo : info.pkgInfoList) {
-        text += m_model->formatePkgInfo(pkgInfo);
+        text += AppManagerModel::formatePkgInfo(pkgInfo);
     }
 
     return text;
 }
 
-void AppManagerWidget::setItemModelFromAppInfoList(const QList<AppInfo> &appInfoList)
+AppManagerWidget::AppDetail AppManagerWidget::loadAppDetail(int requestId, const AppInfo &info)
 {
-    // 先清空数据
-    m_appListModel->removeRows(0, m_appListModel->rowCount());
+    AppDetail detail;
+    detail.requestId = requestId;
+    detail.appInfo = info;
 
-    for (const AppInfo &info : appInfoList) {
-        QList<QStandardItem *> items = createViewItemList(info);
-        m_appListModel->appendRow(items);
+    // 拓展仓库应用信息
+    for (PkgInfo &srvPkgInfo : detail.appInfo.pkgInfoList) {
+        if (!AppManagerModel::extendPkgInfo(srvPkgInfo)) {
+            continue;
+        }
+
+        // 根据版本找到候选包中对应的包大小和下载地址
+        if (detail.appInfo.installedPkgInfo.version == srvPkgInfo.version
+                && detail.appInfo.installedPkgInfo.arch == srvPkgInfo.arch) {
+            detail.appInfo.installedPkgInfo.pkgSize = srvPkgInfo.pkgSize;
+            detail.appInfo.installedPkgInfo.downloadUrl = srvPkgInfo.downloadUrl;
+        }
+    }
+
+    // 文件列表预先排序，显示时不再排序
+    FileListModel::sortFilePathList(detail.appInfo.installedPkgInfo.installedFileList);
+
+    detail.text = formateAppInfo(detail.appInfo, true);
+    return detail;
+}
+
+void AppManagerWidget::requestAppDetail()
+{
+    // 快速切换选中应用时，中间的请求不再加载
+    if (m_appDetailWatcher->isRunning()) {
+        m_isAppDetailRequestPending = true;
+        return;
     }
 
+    m_isAppDetailRequestPending = false;
+    m_appDetailWatcher->setFuture(QtConcurrent::run(&AppManagerWidget::loadAppDetail,
+                                                    m_appDetailRequestId, m_showingAppInfo));
+}
+
+void AppManagerWidget::onAppDetailLoaded()
+{
+    StallSection stallSection(Q_FUNC_INFO);
+    const AppDetail detail = m_appDetailWatcher->result();
+    if (m_appDetailRequestId == detail.requestId) {
+        m_showingAppInfo = detail.appInfo;
+        m_appInfoTextEdit->setText(detail.text);
+    }
+
+    if (m_isAppDetailRequestPending) {
+        requestAppDetail();
+    }
+}
+
+void AppManagerWidget::setAppListFilter(AppListModel::FilterType filterType)
+{
+    StallSection stallSection(Q_FUNC_INFO);
+    m_appListModel->setFilter(filterType);
+
     // 排序
     onSorterMenuTriggered(m_currentSortingAction);
 
@@ -961,57 +869,31 @@ void AppManagerWidget::setItemModelFromAppInfoList(const QList<AppInfo> &appInfo
 void AppManagerWidget::showAllAppInfoList()
 {
     m_displayRangeType = All;
-    setItemModelFromAppInfoList(m_appInfoList);
+    setAppListFilter(AppListModel::FilterAll);
 }
 
 void AppManagerWidget::onlyShowInstalledAppInfoList()
 {
     m_displayRangeType = Installed;
-    QList<AM::AppInfo> installedAppInfoList;
-    for (const AppInfo &info : m_appInfoList) {
-        if (!info.isInstalled) {
-            continue;
-        }
-        installedAppInfoList.append(info);
-    }
-
-    setItemModelFromAppInfoList(installedAppInfoList);
+    setAppListFilter(AppListModel::FilterInstalled);
 }
 
 void AppManagerWidget::onlyShowUIAppInfoList()
 {
     m_displayRangeType = Gui;
-    QList<AM::AppInfo> uiAppInfoList;
-    for (const AppInfo &info : m_appInfoList) {
-        if (info.desktopInfo.desktopPath.isEmpty()) {
-            continue;
-        }
-        uiAppInfoList.append(info);
-    }
-
-    setItemModelFromAppInfoList(uiAppInfoList);
+    setAppListFilter(AppListModel::FilterGui);
 }
 
 void AppManagerWidget::showSearchedAppInfoList()
 {
     m_displayRangeType = Searched;
-    QList<AM::AppInfo> searchedList = m_model->getSearchedAppInfoList();
-
-    setItemModelFromAppInfoList(searchedList);
+    setAppListFilter(AppListModel::FilterSearched);
 }
 
 void AppManagerWidget::showVerHeldAppInfoList()
 {
     m_displayRangeType = VerHeld;
-    QList<AM::AppInfo> verHeldAppInfoList;
-    for (const AppInfo &info : m_appInfoList) {
-        if (!info.installedPkgInfo.isHoldVersion) {
-            continue;
-        }
-        verHeldAppInfoList.append(info);
-    }
-
-    setItemModelFromAppInfoList(verHeldAppInfoList);
+    setAppListFilter(AppListModel::FilterHeld);
 }
 
 void AppManagerWidget::setLoading(bool loading)
@@ -1027,61 +909,37 @@ void AppManagerWidget::setLoading(bool loading)
     }
 }
 
-QList<QStandardItem *> AppManagerWidget::createViewItemList(const AM::AppInfo &appInfo)
-{
-    // 更新列表显示数据
-    QStandardItem *item = new QStandardItem();
-    updateItemFromAppInfo(item, appInfo);
-    QList<QStandardItem *> itemList;
-    itemList << item;
-    return itemList;
-}
-
-void AppManagerWidget::updateItemFromAppInfo(QStandardItem *item, const AppInfo &appInfo)
+AppInfo AppManagerWidget::getAppInfoFromModelIndex(const QModelIndex &index)
 {
-    QString appName = appInfo.desktopInfo.appName;
-    if (appName.isEmpty()) {
-        appName = appInfo.pkgName;
-    }
-    item->setText(appName);
-
-    if (!appInfo.desktopInfo.themeIconName.isEmpty()) {
-        item->setIcon(QIcon::fromTheme(appInfo.desktopInfo.themeIconName));
-    } else {
-        item->setIcon(QIcon::fromTheme(APP_THEME_ICON_DEFAULT));
+    if (!index.isValid() || index.row() >= m_appListModel->rowCount()) {
+        return AppInfo();
     }
-
-    item->setData(ListViewItemMarginVar, Dtk::ItemDataRole::MarginsRole);
-
-    item->setData(QVariant::fromValue(appInfo), AM_LIST_VIEW_ITEM_DATA_ROLE_ALL_DATA);
-    item->setData(appInfo.pkgName, AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_NAME);
-    // 为统一排序，将名称全部转换成小写
-    QString appNameSortStr = getPinYinInfoFromStr(appName).normalPinYin;
-    appNameSortStr = appNameSortStr.toLower();
-    item->setData(appNameSortStr, AM_LIST_VIEW_ITEM_DATA_ROLE_APP_NAME);
-    item->setData(appInfo.installedPkgInfo.pkgSize, AM_LIST_VIEW_ITEM_DATA_ROLE_PKG_SIZE);
-    item->setData(appInfo.installedPkgInfo.installedSize, AM_LIST_VIEW_ITEM_DATA_ROLE_INSTALLED_SIZE);
-    item->setData(appInfo.installedPkgInfo.updatedTime, AM_LIST_VIEW_ITEM_DATA_ROLE_UPDATED_TIME);
+    return m_appListModel->getAppInfo(index.row());
 }
 
-AppInfo AppManagerWidget::getAppInfoFromModelIndex(const QModelIndex &index)
+AppInfo AppManagerWidget::getAppInfoFromListViewModelByPkgName(const QString &pkgName)
 {
-    AppInfo info = index.data(AM_LIST_VIEW_ITEM_DATA_ROLE_ALL_DATA).value<AppInfo>();
-    return info;
+    const int row = m_appListModel->getRowByPkgName(pkgName);
+    if (-1 == row) {
+        return AppInfo();
+    }
+    return m_appListModel->getAppInfo(row);
 }
 
-AppInfo AppManagerWidget::getAppInfoFromListViewModelByPkgName(const QString &pkgName)
+void AppManagerWidget::updateAppInList(const AppInfo &appInfo)
 {
-    for (int i = m_appListModel->rowCount() - 1; i >= 0; --i) {
-        QStandardItem *item = m_appListModel->item(i, 0);
-        const AppInfo &appInfo = getAppInfoFromModelIndex(item->index());
+    StallSection stallSection(Q_FUNC_INFO);
+    // 更新目录及过滤位图，列表中的行随之更新、添加或移除
+    m_appListModel->updateApp(appInfo);
 
-        if (appInfo.pkgName == pkgName) {
-            return appInfo;
-        }
+    // 刷新右侧显示内容
+    if (appInfo.pkgName == m_showingAppInfo.pkgName) {
+        // 更改后，显示列表当前选中应用
+        AppInfo currentAppInfo = getAppInfoFromListViewModelByPkgName(m_showingAppInfo.pkgName);
+        showAppInfo(currentAppInfo);
     }
-
-    return AppInfo();
+    // 更新应用个数标签
+    updateAppCountLabel();
 }
 
 // 更新应用个数标签
@@ -1099,109 +957,171 @@ void AppManagerWidget::updateAppCountLabel()
 
 void AppManagerWidget::updateHighlightText()
 {
-    // 清空上次高亮指针列表
-    m_highlightCursorList.clear();
-    m_currentMovedCursor.clearSelection();
-    // 判断待搜索的文档
-    QTextDocument *doc;
-    if (m_infoBtn->isChecked()) {
-        doc = m_appInfoTextEdit->document();
-    } else if (m_filesBtn->isChecked()) {
-        doc = m_appFileListTextEdit->document();
-    } else {
-        qWarning() << Q_FUNC_INFO << "no info content need find";
+    StallSection stallSection(Q_FUNC_INFO);
+    // 清空上次查找结果，进行中的查找结果将被丢弃
+    ++m_textMatchRequestId;
+    m_matchOffsetList.clear();
+    m_currentMatchIndex = -1;
+    m_matchLength = m_findLineEdit->text().size();
+    updateVisibleHighlight();
+
+    const QString findText = m_findLineEdit->text();
+    if (findText.isEmpty()) {
         return;
     }
-    QTextCursor cursor(doc);
-    // 重置全部文字格式
-    cursor.select(QTextCursor::SelectionType::Document);
-    cursor.setCharFormat(m_appInfoTextEdit->textCursor().charFormat());
-
-    QString findtext = m_findLineEdit->text(); //获得对话框的内容
-//    qInfo() << Q_FUNC_INFO << findtext;
-    if (findtext.isEmpty()) {
+
+    // 在纯文本上查找，位置与文档中的位置一致
+    m_textMatchWatcher->setFuture(QtConcurrent::run(&AppManagerWidget::findTextMatches, m_textMatchRequestId,
+                                                    m_appInfoTextEdit->toPlainText(), findText));
+}
+
+AppManagerWidget::TextMatchResult AppManagerWidget::findTextMatches(int requestId, const QString &text, const QString &findText)
+{
+    TextMatchResult result;
+    result.requestId = requestId;
+    int offset = text.indexOf(findText, 0, Qt::CaseInsensitive);
+    while (-1 != offset) {
+        result.offsetList.append(offset);
+        offset = text.indexOf(findText, offset + findText.size(), Qt::CaseInsensitive);
+    }
+    return result;
+}
+
+void AppManagerWidget::onTextMatchFinished()
+{
+    const TextMatchResult result = m_textMatchWatcher->result();
+    if (m_textMatchRequestId != result.requestId) {
         return;
     }
 
-    QTextCursor highlightCursor(doc);
-    // 开始查找
-    cursor.beginEditBlock();
-    QTextCharFormat colorFormat(highlightCursor.charFormat());
-    colorFormat.setBackground(HighlightTextBgColor);
-    while (!highlightCursor.isNull() && !highlightCursor.atEnd()) {
-        highlightCursor = doc->find(findtext, highlightCursor);
-        if (!highlightCursor.isNull()) {
-            highlightCursor.mergeCharFormat(colorFormat);
-            m_highlightCursorList.append(highlightCursor);
-        }
+    m_matchOffsetList = result.offsetList;
+    m_currentMatchIndex = -1;
+    updateVisibleHighlight();
+}
 
-        qApp->processEvents();
+void AppManagerWidget::updateVisibleHighlight()
+{
+    QList<QTextEdit::ExtraSelection> selectionList;
+    if (!m_matchOffsetList.isEmpty()) {
+        // 可见区域的文字位置范围
+        const QRect viewportRect = m_appInfoTextEdit->viewport()->rect();
+        const int firstPosition = m_appInfoTextEdit->cursorForPosition(viewportRect.topLeft()).position();
+        const int lastPosition = m_appInfoTextEdit->cursorForPosition(viewportRect.bottomRight()).position();
+
+        QVector<int>::const_iterator cIter = std::lower_bound(m_matchOffsetList.cbegin(), m_matchOffsetList.cend(),
+                                                              firstPosition - m_matchLength + 1);
+        for (; m_matchOffsetList.cend() != cIter && lastPosition >= *cIter; ++cIter) {
+            const int matchIndex = int(cIter - m_matchOffsetList.cbegin());
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(m_appInfoTextEdit->document());
+            selection.cursor.setPosition(*cIter);
+            selection.cursor.setPosition(*cIter + m_matchLength, QTextCursor::MoveMode::KeepAnchor);
+            selection.format.setBackground(m_currentMatchIndex == matchIndex ? LocatedHighlightTextBgColor
+                                                                              : HighlightTextBgColor);
+            selectionList.append(selection);
+        }
     }
-    cursor.endEditBlock();
+    m_appInfoTextEdit->setExtraSelections(selectionList);
 }
 
 void AppManagerWidget::moveToNextHighlightText()
 {
-    if (m_highlightCursorList.isEmpty()) {
+    if (m_filesBtn->isChecked()) {
+        moveToMatchedFile(true);
+        return;
+    }
+
+    if (m_matchOffsetList.isEmpty()) {
         qInfo() << Q_FUNC_INFO << "highlight text is empty";
         return;
     }
+    moveToMatch((m_currentMatchIndex + 1) % m_matchOffsetList.size());
+}
 
-    // 判断待搜索的文档编辑器
-    QTextEdit *edit;
-    if (m_infoBtn->isChecked()) {
-        edit = m_appInfoTextEdit;
-    } else if (m_filesBtn->isChecked()) {
-        edit = m_appFileListTextEdit;
-    } else {
-        qWarning() << Q_FUNC_INFO << "no info content need find";
+void AppManagerWidget::moveToPreviousHighlightText()
+{
+    if (m_filesBtn->isChecked()) {
+        moveToMatchedFile(false);
         return;
     }
 
-    QTextCursor nextHighlightCursor;
-    int currentCursorAnchor = edit->textCursor().anchor();
-//    qInfo() << Q_FUNC_INFO << "currentCursorAnchor" << currentCursorAnchor;
-    for (QList<QTextCursor>::const_iterator cIter = m_highlightCursorList.cbegin();
-         cIter != m_highlightCursorList.cend(); ++cIter) {
-        if (currentCursorAnchor < cIter->anchor()) {
-            nextHighlightCursor = *cIter;
-            break;
-        }
+    if (m_matchOffsetList.isEmpty()) {
+        qInfo() << Q_FUNC_INFO << "highlight text is empty";
+        return;
     }
-    if (nextHighlightCursor.isNull()) {
-        nextHighlightCursor = m_highlightCursorList.first();
+    const int matchIndex = (0 >= m_currentMatchIndex) ? m_matchOffsetList.size() - 1 : m_currentMatchIndex - 1;
+    moveToMatch(matchIndex);
+}
+
+void AppManagerWidget::moveToMatch(int matchIndex)
+{
+    m_currentMatchIndex = matchIndex;
+    QTextCursor cursor = m_appInfoTextEdit->textCursor();
+    cursor.setPosition(m_matchOffsetList.at(matchIndex));
+    m_appInfoTextEdit->setTextCursor(cursor);
+    m_appInfoTextEdit->ensureCursorVisible();
+    updateVisibleHighlight();
+}
+
+void AppManagerWidget::updateFileMatches()
+{
+    // 清空上次查找结果，进行中的查找结果将被丢弃
+    ++m_fileMatchRequestId;
+    m_matchedPathIndexList.clear();
+
+    const QString findText = m_findLineEdit->text();
+    if (findText.isEmpty() || m_fileListModel->getFilePathList().isEmpty()) {
+        return;
     }
-    int nextHighlightCursorAnchor = nextHighlightCursor.anchor();
-//    qInfo() << Q_FUNC_INFO << "nextHighlightCursorAnchor" << nextHighlightCursorAnchor;
-
-    bool finded = true; // 是否找到
-    bool haveLoopFinded = false; // 只循环查找一次
-    edit->moveCursor(QTextCursor::MoveOperation::PreviousCharacter, QTextCursor::MoveMode::MoveAnchor);
-    while (edit->textCursor().anchor() != nextHighlightCursorAnchor) {
-        edit->moveCursor(QTextCursor::MoveOperation::NextCharacter, QTextCursor::MoveMode::MoveAnchor);
-        // 当移到文档末尾时还没找到高亮文字指针
-        if (edit->textCursor().atEnd()) {
-            if (!haveLoopFinded) {
-                QTextCursor currentCursor = edit->textCursor();
-                currentCursor.movePosition(QTextCursor::MoveOperation::Start, QTextCursor::MoveMode::MoveAnchor);
-                edit->setTextCursor(currentCursor);
-                haveLoopFinded = true;
-                 qInfo() << Q_FUNC_INFO << "move to start" << edit->textCursor().anchor();
-            } else {
-                finded = false;
-                break;
-            }
-        }
+
+    // 路径列表隐式共享，传给工作线程不复制
+    m_fileMatchWatcher->setFuture(QtConcurrent::run(&AppManagerWidget::findFileMatches, m_fileMatchRequestId,
+                                                    m_fileListModel->getFilePathList(), findText));
+}
+
+AppManagerWidget::FileMatchResult AppManagerWidget::findFileMatches(int requestId, const QStringList &filePathList, const QString &findText)
+{
+    FileMatchResult result;
+    result.requestId = requestId;
+    result.pathIndexList = FileListModel::findPaths(filePathList, findText);
+    return result;
+}
+
+void AppManagerWidget::onFileMatchFinished()
+{
+    const FileMatchResult result = m_fileMatchWatcher->result();
+    if (m_fileMatchRequestId != result.requestId) {
+        return;
     }
 
-    // 还原上次移到到的高亮文字背景颜色
-    QTextCharFormat colorFormat(m_currentMovedCursor.charFormat());
-    colorFormat.setBackground(HighlightTextBgColor);
-    m_currentMovedCursor.setCharFormat(colorFormat);
+    m_matchedPathIndexList = result.pathIndexList;
+}
 
-    // 设置当前移到到的高亮文字背景颜色
-    m_currentMovedCursor = nextHighlightCursor;
-    colorFormat = m_currentMovedCursor.charFormat();
-    colorFormat.setBackground(LocatedHighlightTextBgColor);
-    m_currentMovedCursor.mergeCharFormat(colorFormat);
+void AppManagerWidget::moveToMatchedFile(bool isForward)
+{
+    if (m_matchedPathIndexList.isEmpty()) {
+        qInfo() << Q_FUNC_INFO << "no matched file";
+        return;
+    }
+
+    // 在匹配路径中二分查找当前路径的下一个/上一个，到头后循环，未定位时向后从第一个开始，向前从最后一个开始
+    const int currentPathIndex = m_fileListModel->getPathIndex(m_appFileListView->currentIndex());
+    int pathIndex = -1;
+    if (isForward) {
+        QVector<int>::const_iterator cIter = std::upper_bound(m_matchedPathIndexList.cbegin(),
+                                                              m_matchedPathIndexList.cend(), currentPathIndex);
+        pathIndex = (m_matchedPathIndexList.cend() == cIter) ? m_matchedPathIndexList.first() : *cIter;
+    } else {
+        QVector<int>::const_iterator cIter = std::lower_bound(m_matchedPathIndexList.cbegin(),
+                                                              m_matchedPathIndexList.cend(), currentPathIndex);
+        pathIndex = (m_matchedPathIndexList.cbegin() == cIter) ? m_matchedPathIndexList.last() : *(cIter - 1);
+    }
+
+    // 按需生成上层目录节点，展开后定位
+    const QModelIndex modelIndex = m_fileListModel->getPathModelIndex(pathIndex);
+    for (QModelIndex parentIndex = modelIndex.parent(); parentIndex.isValid(); parentIndex = parentIndex.parent()) {
+        m_appFileListView->expand(parentIndex);
+    }
+    m_appFileListView->setCurrentIndex(modelIndex);
+    m_appFileListView->scrollTo(modelIndex);
 }
@@ -2,12 +2,13 @@
 
 #include "common/appmanagercommon.h"
 #include "appmanagermodel.h"
+#include "applistmodel.h"
+#include "filelistmodel.h"
 
 #include <DFrame>
 
-#include <QStandardItem>
 #include <QComboBox>
-#include <QTextCursor>
+#include <QFutureWatcher>
 
 class AppManagerModel;
 
@@ -19,8 +20,8 @@ class DButtonBox;
 class DSpinner;
 DWIDGET_END_NAMESPACE
 
-class QStandardItemModel;
 class QTextEdit;
+class QTreeView;
 class QLabel;
 class QWidget;
 class QLineEdit;
@@ -40,14 +41,46 @@ public:
         VerHeld //保持版本
     };
 
+    // 应用详情，在工作线程中加载
+    struct AppDetail {
+        int requestId; // 详情请求id
+        AM::AppInfo appInfo; // 拓展仓库信息后的应用信息
+        QString text; // 应用信息文本
+        AppDetail()
+        {
+            requestId = 0;
+        }
+    };
+
+    // 查找结果，在工作线程中计算
+    struct TextMatchResult {
+        int requestId; // 查找请求id
+        QVector<int> offsetList; // 匹配文字在文本中的位置，升序
+        TextMatchResult()
+        {
+            requestId = 0;
+        }
+    };
+
+    // 文件列表查找结果，在工作线程中计算
+    struct FileMatchResult {
+        int requestId; // 查找请求id
+        QVector<int> pathIndexList; // 包含查找文字的路径下标，升序
+        FileMatchResult()
+        {
+            requestId = 0;
+        }
+    };
+
     AppManagerWidget(AppManagerModel *model, QWidget *parent = nullptr);
     virtual ~AppManagerWidget() override;
 
 public Q_SLOTS:
     void showAppInfo(const AM::AppInfo &info);
     void showAppFileList(const AM::AppInfo &info);
-    void onSearchEditingFinished();
-    void onSearchTaskFinished();
+    void onSearchTextChanged(const QString &text);
+    void onSearchResultsFound(int searchId, const QList<AM::AppInfo> &appInfoList);
+    void onSearchTaskFinished(int searchId);
     // 软件安装变动
     void onAppInstalled(const AM::AppInfo &appInfo);
     void onAppUpdated(const AM::AppInfo &appInfo);
@@ -55,11 +88,24 @@ public Q_SLOTS:
     // 当排序器出发后
     void onSorterMenuTriggered(QAction *action);
 
-private:
-    QString formateAppInfo(const AM::AppInfo &info);
+private Q_SLOTS:
+    // 应用详情加载完成
+    void onAppDetailLoaded();
+    // 查找完成
+    void onTextMatchFinished();
+    // 文件列表查找完成
+    void onFileMatchFinished();
 
-    // 根据应用信息列表设置标准单元数据对象数据
-    void setItemModelFromAppInfoList(const QList<AM::AppInfo> &appInfoList);
+private:
+    // isRepoPkgInfoReady为false时（仓库安装包信息尚未拓展），仓库安装包信息显示为加载中
+    static QString formateAppInfo(const AM::AppInfo &info, bool isRepoPkgInfoReady);
+    // 拓展仓库安装包信息并生成应用信息文本，在工作线程中执行
+    static AppDetail loadAppDetail(int requestId, const AM::AppInfo &info);
+    // 加载正在显示的应用详情，已有加载任务时，等其完成后只加载最新的请求
+    void requestAppDetail();
+
+    // 设置列表显示范围
+    void setAppListFilter(AppListModel::FilterType filterType);
     void showAllAppInfoList();
     void onlyShowInstalledAppInfoList();
     void onlyShowUIAppInfoList();
@@ -67,21 +113,35 @@ private:
     void showVerHeldAppInfoList();
 
     void setLoading(bool loading);
-    QList<QStandardItem *> createViewItemList(const AM::AppInfo &appInfo);
-    void updateItemFromAppInfo(QStandardItem *item, const AM::AppInfo &appInfo);
     AppInfo getAppInfoFromModelIndex(const QModelIndex &index);
     AppInfo getAppInfoFromListViewModelByPkgName(const QString &pkgName);
+    // 应用信息变化后，更新目录和列表
+    void updateAppInList(const AM::AppInfo &appInfo);
 
     // 更新应用个数标签
     void updateAppCountLabel();
-    // 更新高亮显示文字
+    // 在工作线程中查找信息文本，完成后更新高亮显示文字
     void updateHighlightText();
-    // 移动到下一个高亮显示文字
+    // 在文本中查找全部匹配位置，在工作线程中执行
+    static TextMatchResult findTextMatches(int requestId, const QString &text, const QString &findText);
+    // 只高亮显示可见区域内的匹配文字
+    void updateVisibleHighlight();
+    // 移动到下一个/上一个高亮显示文字
     void moveToNextHighlightText();
+    void moveToPreviousHighlightText();
+    void moveToMatch(int matchIndex);
+    // 查找文字或文件列表变化后，在工作线程中查找包含查找文字的全部路径
+    void updateFileMatches();
+    // 在路径列表中查找，在工作线程中执行
+    static FileMatchResult findFileMatches(int requestId, const QStringList &filePathList, const QString &findText);
+    // 文件列表中定位到下一个/上一个包含查找文字的路径
+    void moveToMatchedFile(bool isForward);
 
 private:
-    QList<AM::AppInfo> m_appInfoList;
     AM::AppInfo m_showingAppInfo;
+    QFutureWatcher<AppDetail> *m_appDetailWatcher;
+    int m_appDetailRequestId; // 最新的详情请求id，完成时id不一致的结果丢弃
+    bool m_isAppDetailRequestPending; // 是否有等待加载的详情请求
 
     AppManagerModel *m_model;
 
@@ -89,6 +149,7 @@ private:
     QWidget *m_contentWidget;
 
     QLineEdit *m_searchLineEdit;
+    int m_showingSearchId; // 列表中正在显示的搜索id
     QMenu *m_filterMenu;
     QAction *m_showAllAppAction;
     QAction *m_showInstalledAppAction;
@@ -103,7 +164,7 @@ private:
     QAction *m_descendingSortByUpdatedTimeAction;
     QAction *m_currentSortingAction;
 
-    QStandardItemModel *m_appListModel;
+    AppListModel *m_appListModel;
     DListView *m_appListView;
     QLabel *m_appCountLabel; // 应用个数标签
     QLabel *m_appAbstractLabel;
@@ -114,8 +175,15 @@ private:
     DButtonBoxButton *m_filesBtn;
     DButtonBox *m_infoSwitchBtn;
     QLineEdit *m_findLineEdit;
-    QList<QTextCursor> m_highlightCursorList;
-    QTextCursor m_currentMovedCursor;
+    QFutureWatcher<TextMatchResult> *m_textMatchWatcher;
+    int m_textMatchRequestId; // 最新的查找请求id，完成时id不一致的结果丢弃
+    QVector<int> m_matchOffsetList; // 匹配文字位置，升序
+    int m_matchLength; // 匹配文字长度
+    int m_currentMatchIndex; // 当前定位到的匹配序号，-1表示未定位
     QTextEdit *m_appInfoTextEdit;
-    QTextEdit *m_appFileListTextEdit;
+    FileListModel *m_fileListModel;
+    QFutureWatcher<FileMatchResult> *m_fileMatchWatcher;
+    int m_fileMatchRequestId; // 最新的文件列表查找请求id，完成时id不一致的结果丢弃
+    QVector<int> m_matchedPathIndexList; // 包含查找文字的路径下标，升序
+    QTreeView *m_appFileListView;
 };
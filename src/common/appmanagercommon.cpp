@@ -1,14 +1,11 @@
 #include "appmanagercommon.h"
-
-#include <DtkCores>
+#include "pinyintable.h"
 
 // 汉字方法相关
-const QRegularExpression OnlyNumRegular = QRegularExpression("^[0-9]+$");
-
 bool AM::isChineseChar(const QChar &character)
 {
     ushort unicode = character.unicode();
-    if (unicode >= 0x4E00 && unicode <= 0x9FFF) {
+    if (unicode >= PINYIN_TABLE_FIRST_CHAR && unicode <= PINYIN_TABLE_LAST_CHAR) {
         return true;
     }
     return false;
@@ -16,36 +13,49 @@ bool AM::isChineseChar(const QChar &character)
 
 AM::PinyinInfo AM::getPinYinInfoFromStr(const QString &words)
 {
+    // 遇到第一个汉字时才取拼音表，纯英文名称不需要拼音表
+    const PinyinTable *pinyinTable = nullptr;
     PinyinInfo result;
     for (const QChar &singleChar : words) {
-        QString singlePinyin = Dtk::Core::Chinese2Pinyin(singleChar);
-        result.normalPinYin.append(singlePinyin);
-
         // 如果非汉字，则不转换
         if (!isChineseChar(singleChar)) {
+            result.normalPinYin.append(singleChar);
             result.noTonePinYin.append(singleChar);
             result.simpliyiedPinYin.append(singleChar);
             continue;
         }
-        // 无声调拼音
-        QString singleNoTonePinyin;
-        // 去除声调
-        for (const QChar &singlePinyinChar : singlePinyin) {
-            QRegularExpressionMatch match = OnlyNumRegular.match(singlePinyinChar, 0);
-            if (match.hasMatch()) {
-                continue;
-            }
-            singleNoTonePinyin.append(singlePinyinChar);
-        }
-        result.noTonePinYin.append(singleNoTonePinyin);
 
+        if (!pinyinTable) {
+            pinyinTable = PinyinTable::instance();
+        }
+        result.normalPinYin.append(pinyinTable->getTonedPinYin(singleChar));
+        // 无声调拼音
+        result.noTonePinYin.append(pinyinTable->getNoTonePinYin(singleChar));
         // 首字母
-        result.simpliyiedPinYin.append(singlePinyin.front());
+        result.simpliyiedPinYin.append(pinyinTable->getInitial(singleChar));
     }
 
     return result;
 }
 
+void AM::updateAppSearchKeys(AppInfo &appInfo)
+{
+    AppSearchKeys &keys = appInfo.searchKeys;
+    keys.pkgNameLower = appInfo.pkgName.toLower();
+    keys.appNameLower = appInfo.desktopInfo.appName.toLower();
+
+    const PinyinInfo pinYinInfo = getPinYinInfoFromStr(appInfo.desktopInfo.appName);
+    keys.noTonePinYin = pinYinInfo.noTonePinYin;
+    keys.simpliyiedPinYin = pinYinInfo.simpliyiedPinYin;
+
+    // 无应用名时按包名排序，为统一排序，将名称全部转换成小写
+    if (appInfo.desktopInfo.appName.isEmpty()) {
+        keys.nameSortKey = keys.pkgNameLower;
+    } else {
+        keys.nameSortKey = pinYinInfo.normalPinYin.toLower();
+    }
+}
+
 void AM::popupNormalSysNotify(const QString &summary, const QString &body)
 {
     QProcess proc;
@@ -51,11 +51,14 @@ struct PkgInfo {
     bool isHoldVersion; // 是否保持版本
     int installedSize;
     QString updatedTime;
+    qint64 updatedTimestamp; // 更新时间（毫秒），用于排序
     QString maintainer;
     QString arch;
     QString version;
     QString downloadUrl;
     int pkgSize;
+    QString sha256; // 安装包SHA256校验值（十六进制）
+    QString md5sum; // 安装包MD5校验值（十六进制），无SHA256时使用
     QString homepage;
     QString depends;
     QString description;
@@ -64,6 +67,7 @@ struct PkgInfo {
     {
         contentOffset = 0;
         contentSize = 0;
+        updatedTimestamp = 0;
         installedSize = 0;
         isInstalled = false;
         isHoldVersion = false;
@@ -84,12 +88,22 @@ struct DesktopInfo {
     }
 };
 
+// 搜索及排序关键字，加载或更新应用信息时预先计算，搜索和排序时直接使用
+struct AppSearchKeys {
+    QString pkgNameLower; // 小写包名
+    QString appNameLower; // 小写应用名
+    QString noTonePinYin; // 应用名无声调拼音
+    QString simpliyiedPinYin; // 应用名拼音首字母
+    QString nameSortKey; // 名称排序关键字，显示名称的小写拼音
+};
+
 struct AppInfo {
     QString pkgName; // 包名作为唯一识别信息
     QList<PkgInfo> pkgInfoList;
     bool isInstalled;
     PkgInfo installedPkgInfo;
     DesktopInfo desktopInfo;
+    AppSearchKeys searchKeys; // 搜索关键字
     AppInfo()
     {
         isInstalled = false;
@@ -111,6 +125,8 @@ struct PinyinInfo {
 bool isChineseChar(const QChar &character);
 // 字符串转拼音
 PinyinInfo getPinYinInfoFromStr(const QString &words);
+// 根据包名和应用名更新搜索及排序关键字
+void updateAppSearchKeys(AppInfo &appInfo);
 
 void popupNormalSysNotify(const QString &summary, const QString &body);
 // 格式化容量
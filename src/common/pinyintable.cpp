@@ -0,0 +1,33 @@
+#include "pinyintable.h"
+#include "pinyintabledata.h"
+
+Q_GLOBAL_STATIC(PinyinTable, GlobalPinyinTable)
+
+PinyinTable::PinyinTable()
+{
+    // 只需转换音节池，汉字到音节的下标直接使用生成的数组
+    m_syllableList.reserve(PINYIN_TABLE_SYLLABLE_COUNT);
+    for (const char *syllable : PinyinSyllables) {
+        m_syllableList.append(QString::fromUtf8(syllable));
+    }
+}
+
+const PinyinTable *PinyinTable::instance()
+{
+    return GlobalPinyinTable();
+}
+
+const QString &PinyinTable::getTonedPinYin(const QChar &character) const
+{
+    return m_syllableList.at(PinyinTonedIndexes[character.unicode() - PINYIN_TABLE_FIRST_CHAR]);
+}
+
+const QString &PinyinTable::getNoTonePinYin(const QChar &character) const
+{
+    return m_syllableList.at(PinyinNoToneIndexes[character.unicode() - PINYIN_TABLE_FIRST_CHAR]);
+}
+
+QChar PinyinTable::getInitial(const QChar &character) const
+{
+    return getTonedPinYin(character).front();
+}
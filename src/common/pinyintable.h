@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QChar>
+#include <QStringList>
+
+// 汉字编码范围
+#define PINYIN_TABLE_FIRST_CHAR 0x4E00
+#define PINYIN_TABLE_LAST_CHAR 0x9FFF
+
+// 汉字拼音表
+// 0x4E00-0x9FFF范围内每个汉字的带声调拼音、无声调拼音在音节池中的下标由tools/pinyintablegen在构建时生成，
+// 运行时只需查表
+class PinyinTable
+{
+public:
+    // 请通过instance()获取
+    PinyinTable();
+
+    static const PinyinTable *instance();
+
+    // 以下接口的character需为汉字
+    // 带声调拼音，如"zhong1"
+    const QString &getTonedPinYin(const QChar &character) const;
+    // 无声调拼音，如"zhong"
+    const QString &getNoTonePinYin(const QChar &character) const;
+    // 拼音首字母
+    QChar getInitial(const QChar &character) const;
+
+private:
+    QStringList m_syllableList; // 音节池，读音数量远少于汉字数量
+};
@@ -28,6 +28,7 @@ PkgDownloadDlg::PkgDownloadDlg(const AM::AppInfo &appInfo, AppManagerModel *mode
     , m_versionSelectBtn(nullptr)
     , m_downloadBtn(nullptr)
     , m_isDownloading(false)
+    , m_downloadId(-1)
     , m_openDirBtn(nullptr)
     , m_pkgSizeLable(nullptr)
     , m_progressBar(nullptr)
@@ -208,13 +209,18 @@ void PkgDownloadDlg::onVerSelectMenuTrigered(QAction *trigeredAction)
     m_infoEdit->setText(infoText);
 }
 
-void PkgDownloadDlg::onFileDownloadProgressChanged(const AM::PkgInfo &info, qint64 bytesRead, qint64 totalBytes)
+void PkgDownloadDlg::onFileDownloadProgressChanged(int downloadId, const AM::PkgInfo &info, qint64 bytesRead, qint64 totalBytes)
 {
-    if (m_selectedPkgInfo.pkgName != info.pkgName) {
+    Q_UNUSED(info);
+    if (m_downloadId != downloadId) {
         return;
     }
 
     m_pkgSizeLable->setText(QString("%1B/%2B").arg(bytesRead).arg(totalBytes));
+    // 大小未知时不更新进度条
+    if (0 >= totalBytes) {
+        return;
+    }
 
     double downloadPercent = double(bytesRead) / totalBytes;
     m_progressBar->setValue(int(100 * downloadPercent));
@@ -224,7 +230,12 @@ void PkgDownloadDlg::initConnection()
 {
     connect(m_versionSelectMenu, &QMenu::triggered, this, &PkgDownloadDlg::onVerSelectMenuTrigered);
     connect(m_downloadBtn, &QPushButton::clicked, this, [this](bool) {
-        this->m_model->notifyThreadDownloadPkgFile(m_selectedPkgInfo);
+        // 下载中时为取消按钮
+        if (this->m_isDownloading) {
+            this->m_model->cancelPkgFileDownload(m_downloadId);
+            return;
+        }
+        this->m_downloadId = this->m_model->startDownloadPkgFile(m_selectedPkgInfo);
         this->m_isDownloading = true;
         this->updateUI();
     });
@@ -243,13 +254,30 @@ void PkgDownloadDlg::initConnection()
     });
 
     connect(m_model, &AppManagerModel::pkgFileDownloadProgressChanged, this, &PkgDownloadDlg::onFileDownloadProgressChanged);
-    connect(m_model, &AppManagerModel::pkgFileDownloadFinished, this, [this](const AM::PkgInfo &info) {
+    connect(m_model, &AppManagerModel::pkgFileDownloadFinished, this, [this](int downloadId, const AM::PkgInfo &info) {
+        if (this->m_downloadId != downloadId) {
+            return;
+        }
         qInfo() << Q_FUNC_INFO << info.downloadUrl << "downloaded";
+        this->m_downloadId = -1;
         this->m_isDownloading = false;
         this->updateUI();
     });
-    connect(m_model, &AppManagerModel::pkgFileDownloadFailed, this, [this](const AM::PkgInfo &info) {
+    connect(m_model, &AppManagerModel::pkgFileDownloadFailed, this, [this](int downloadId, const AM::PkgInfo &info) {
+        if (this->m_downloadId != downloadId) {
+            return;
+        }
         qInfo() << Q_FUNC_INFO << info.downloadUrl << "download failed!";
+        this->m_downloadId = -1;
+        this->m_isDownloading = false;
+        this->updateUI();
+    });
+    connect(m_model, &AppManagerModel::pkgFileDownloadCanceled, this, [this](int downloadId, const AM::PkgInfo &info) {
+        if (this->m_downloadId != downloadId) {
+            return;
+        }
+        qInfo() << Q_FUNC_INFO << info.downloadUrl << "download canceled";
+        this->m_downloadId = -1;
         this->m_isDownloading = false;
         this->updateUI();
     });
@@ -260,10 +288,10 @@ void PkgDownloadDlg::updateUI()
     if (m_isDownloading) {
         m_titlebar->setEnabled(false);
         m_versionSelectBtn->setEnabled(false);
-        m_downloadBtn->setEnabled(false);
+        m_downloadBtn->setText("取消");
     } else {
         m_titlebar->setEnabled(true);
         m_versionSelectBtn->setEnabled(true);
-        m_downloadBtn->setEnabled(true);
+        m_downloadBtn->setText("下载");
     }
 }
@@ -32,7 +32,7 @@ protected:
 
 public Q_SLOTS:
     void onVerSelectMenuTrigered(QAction *action);
-    void onFileDownloadProgressChanged(const AM::PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
+    void onFileDownloadProgressChanged(int downloadId, const AM::PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
 
 private:
     void initConnection();
@@ -50,6 +50,7 @@ private:
     QPushButton *m_versionSelectBtn;
     QPushButton *m_downloadBtn;
     bool m_isDownloading;
+    int m_downloadId; // 当前下载编号，未下载时为-1
     QPushButton *m_openDirBtn;
     QLabel *m_pkgSizeLable;
     DProgressBar *m_progressBar;
@@ -0,0 +1,152 @@
+#include "pkgdownloadmanager.h"
+#include "pkgdownloadtask.h"
+
+#include <QDebug>
+
+PkgDownloadManager::PkgDownloadManager(QNetworkAccessManager *netManager, QObject *parent)
+    : QObject(parent)
+    , m_netManager(netManager)
+    , m_maxRunningCount(PKG_DOWNLOAD_MAX_RUNNING_COUNT)
+{
+}
+
+PkgDownloadManager::~PkgDownloadManager()
+{
+    while (!m_itemList.isEmpty()) {
+        removeItem(m_itemList.size() - 1);
+    }
+}
+
+void PkgDownloadManager::setMaxRunningCount(int count)
+{
+    m_maxRunningCount = qMax(1, count);
+    startWaitingDownloads();
+}
+
+int PkgDownloadManager::getMaxRunningCount() const
+{
+    return m_maxRunningCount;
+}
+
+void PkgDownloadManager::addDownload(int downloadId, const QString &url, const QString &filePath, qint64 fileSize,
+                                     QCryptographicHash::Algorithm checksumAlgorithm, const QString &checksum)
+{
+    for (const DownloadItem &item : m_itemList) {
+        if (filePath == item.filePath) {
+            Q_EMIT downloadFailed(downloadId, QString("%1 is already downloading").arg(filePath));
+            return;
+        }
+    }
+
+    DownloadItem item;
+    item.id = downloadId;
+    item.url = url;
+    item.filePath = filePath;
+    item.fileSize = fileSize;
+    item.checksumAlgorithm = checksumAlgorithm;
+    item.checksum = checksum;
+    m_itemList.append(item);
+    startWaitingDownloads();
+}
+
+void PkgDownloadManager::cancelDownload(int downloadId)
+{
+    const int index = findItem(downloadId);
+    if (-1 == index) {
+        return;
+    }
+
+    removeItem(index);
+    Q_EMIT downloadCanceled(downloadId);
+    startWaitingDownloads();
+}
+
+bool PkgDownloadManager::isDownloading(int downloadId) const
+{
+    return -1 != findItem(downloadId);
+}
+
+void PkgDownloadManager::startWaitingDownloads()
+{
+    const int runningCount = qMin(m_maxRunningCount, m_itemList.size());
+    if (getRunningCount() >= runningCount) {
+        return;
+    }
+
+    // 连接数按本次同时下载数平分，只有一个下载时不必给后面的下载预留连接；
+    // 之后加入的下载使总数暂时超过上限时，多出的请求由QNetworkAccessManager排队
+    const int connectionCount = qBound(1, PKG_DOWNLOAD_MAX_CONNECTION_COUNT / runningCount, PKG_DOWNLOAD_SEGMENT_COUNT);
+    // 任务开始时可能同步完成或失败，其处理中会修改下载列表，因此先创建任务，遍历结束后再开始
+    QList<int> startingIdList;
+    for (DownloadItem &item : m_itemList) {
+        if (getRunningCount() >= runningCount) {
+            break;
+        }
+        if (item.task) {
+            continue;
+        }
+
+        const int downloadId = item.id;
+        qInfo() << Q_FUNC_INFO << downloadId << item.url << "connections:" << connectionCount;
+        item.task = new PkgDownloadTask(m_netManager, item.url, item.filePath, item.fileSize, connectionCount, this);
+        item.task->setChecksum(item.checksumAlgorithm, item.checksum);
+        connect(item.task, &PkgDownloadTask::progressChanged, this, [this, downloadId](qint64 bytesReceived, qint64 bytesTotal) {
+            Q_EMIT this->downloadProgressChanged(downloadId, bytesReceived, bytesTotal);
+        });
+        connect(item.task, &PkgDownloadTask::finished, this, [this, downloadId] {
+            removeItem(findItem(downloadId));
+            Q_EMIT this->downloadFinished(downloadId);
+            startWaitingDownloads();
+        });
+        connect(item.task, &PkgDownloadTask::failed, this, [this, downloadId](const QString &err) {
+            removeItem(findItem(downloadId));
+            Q_EMIT this->downloadFailed(downloadId, err);
+            startWaitingDownloads();
+        });
+        startingIdList.append(downloadId);
+    }
+
+    for (int downloadId : startingIdList) {
+        const int index = findItem(downloadId);
+        if (-1 != index) {
+            m_itemList.at(index).task->start();
+        }
+    }
+}
+
+int PkgDownloadManager::findItem(int downloadId) const
+{
+    for (int i = 0; i < m_itemList.size(); ++i) {
+        if (downloadId == m_itemList.at(i).id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int PkgDownloadManager::getRunningCount() const
+{
+    int count = 0;
+    for (const DownloadItem &item : m_itemList) {
+        if (item.task) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void PkgDownloadManager::removeItem(int index)
+{
+    if (0 > index || m_itemList.size() <= index) {
+        return;
+    }
+
+    PkgDownloadTask *task = m_itemList.at(index).task;
+    m_itemList.removeAt(index);
+    if (task) {
+        task->disconnect(this);
+        task->abort();
+        // 可能正在任务的信号中，延后释放
+        task->deleteLater();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QCryptographicHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+QT_END_NAMESPACE
+
+class PkgDownloadTask;
+
+// 默认同时进行的下载数
+#define PKG_DOWNLOAD_MAX_RUNNING_COUNT 3
+// 所有下载共用的连接数，与QNetworkAccessManager对同一主机的连接数上限一致，超出的请求会排队
+#define PKG_DOWNLOAD_MAX_CONNECTION_COUNT 6
+
+// 安装包下载队列
+// 每个下载由调用方分配的编号标识，超过同时下载数的排队等待；
+// 任务开始时按同时下载数平分连接数，单个下载可用全部分段，多个下载时避免先开始的下载占满连接
+class PkgDownloadManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PkgDownloadManager(QNetworkAccessManager *netManager, QObject *parent = nullptr);
+    virtual ~PkgDownloadManager() override;
+
+    void setMaxRunningCount(int count);
+    int getMaxRunningCount() const;
+
+    // 加入下载队列，fileSize未知时传-1；同一文件已在队列中时失败
+    // checksum不为空时下载完成后校验，不一致时失败
+    void addDownload(int downloadId, const QString &url, const QString &filePath, qint64 fileSize,
+                     QCryptographicHash::Algorithm checksumAlgorithm = QCryptographicHash::Sha256,
+                     const QString &checksum = QString());
+    // 取消下载，已下载的部分保留，再次下载时续传
+    void cancelDownload(int downloadId);
+    bool isDownloading(int downloadId) const;
+
+Q_SIGNALS:
+    void downloadProgressChanged(int downloadId, qint64 bytesReceived, qint64 bytesTotal);
+    void downloadFinished(int downloadId);
+    void downloadFailed(int downloadId, const QString &err);
+    void downloadCanceled(int downloadId);
+
+private:
+    struct DownloadItem {
+        int id;
+        QString url;
+        QString filePath;
+        qint64 fileSize;
+        QCryptographicHash::Algorithm checksumAlgorithm;
+        QString checksum;
+        PkgDownloadTask *task; // 排队时为空
+        DownloadItem()
+        {
+            id = -1;
+            fileSize = -1;
+            checksumAlgorithm = QCryptographicHash::Sha256;
+            task = nullptr;
+        }
+    };
+
+    // 按加入顺序开始排队的下载
+    void startWaitingDownloads();
+    int findItem(int downloadId) const;
+    int getRunningCount() const;
+    // 移除下载，中止并释放其任务
+    void removeItem(int index);
+
+private:
+    QNetworkAccessManager *m_netManager;
+    int m_maxRunningCount;
+    QList<DownloadItem> m_itemList; // 按加入顺序
+};
@@ -0,0 +1,866 @@
+#include "pkgdownloadtask.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSettings>
+#include <QSslConfiguration>
+#include <QTimer>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+PkgDownloadTask::PkgDownloadTask(QNetworkAccessManager *netManager, const QString &url, const QString &filePath,
+                                 qint64 fileSize, int segmentCount, QObject *parent)
+    : QObject(parent)
+    , m_netManager(netManager)
+    , m_url(url)
+    , m_filePath(filePath)
+    , m_fileSize(fileSize)
+    , m_segmentCount(qMax(1, segmentCount))
+    , m_fd(-1)
+    , m_isRunning(false)
+    , m_isRangeSupported(true)
+    , m_lastSegmentId(0)
+    , m_saveStateTimer(nullptr)
+    , m_hashTimer(nullptr)
+    , m_hash(nullptr)
+    , m_hashedOffset(0)
+    , m_readBuffer(PKG_DOWNLOAD_READ_BUFFER_SIZE, Qt::Uninitialized)
+{
+    m_saveStateTimer = new QTimer(this);
+    m_saveStateTimer->setInterval(PKG_DOWNLOAD_STATE_SAVE_INTERVAL_MS);
+    connect(m_saveStateTimer, &QTimer::timeout, this, [this] {
+        saveWrittenBackState();
+    });
+
+    m_hashTimer = new QTimer(this);
+    m_hashTimer->setSingleShot(true);
+    m_hashTimer->setInterval(0);
+    connect(m_hashTimer, &QTimer::timeout, this, &PkgDownloadTask::onHashTimerTimeout);
+}
+
+PkgDownloadTask::~PkgDownloadTask()
+{
+    abort();
+    delete m_hash;
+    m_hash = nullptr;
+}
+
+void PkgDownloadTask::setChecksum(QCryptographicHash::Algorithm algorithm, const QString &checksum)
+{
+    delete m_hash;
+    m_hash = nullptr;
+    m_checksum = checksum.trimmed().toLower();
+    if (!m_checksum.isEmpty()) {
+        m_hash = new QCryptographicHash(algorithm);
+    }
+}
+
+void PkgDownloadTask::start()
+{
+    if (m_isRunning) {
+        return;
+    }
+
+    // 大小未知时无法续传
+    if (0 < m_fileSize) {
+        loadState();
+    }
+    // 状态文件中的范围已经落盘
+    m_writingBackRangeList = m_completedRangeList;
+
+    // 补算校验值时需要读取
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+    if (m_completedRangeList.isEmpty()) {
+        flags |= O_TRUNC;
+    }
+    m_fd = ::open(getPartFilePath().toLocal8Bit().constData(), flags, 0644);
+    if (-1 == m_fd) {
+        fail(QString("open %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+        return;
+    }
+    m_isRunning = true;
+    m_saveStateTimer->start();
+
+    // 大小未知时先请求到文件末尾，从响应中得到大小后再分段
+    if (0 >= m_fileSize) {
+        startSegment(0, -1);
+        return;
+    }
+
+    // 续传时先补算上次已完成的开头部分
+    if (!prepareFile()) {
+        return;
+    }
+
+    // 上次已全部下载完成，补算完校验值后重命名
+    if (m_fileSize == getReceivedBytes()) {
+        tryFinish();
+        return;
+    }
+
+    // 先只请求第一段，得到重定向后的地址并确认大小后再请求其他段
+    splitMissingRanges();
+    const ByteRange range = m_pendingRangeList.takeFirst();
+    startSegment(range.first, range.second - 1);
+}
+
+void PkgDownloadTask::abort()
+{
+    if (!m_isRunning) {
+        return;
+    }
+
+    m_isRunning = false;
+    m_saveStateTimer->stop();
+    m_hashTimer->stop();
+    saveState();
+    abortSegments();
+    closeFile();
+}
+
+QString PkgDownloadTask::getUrl() const
+{
+    return m_url;
+}
+
+QString PkgDownloadTask::getFilePath() const
+{
+    return m_filePath;
+}
+
+void PkgDownloadTask::onSegmentReadyRead()
+{
+    int index = findSegment(qobject_cast<QNetworkReply *>(sender()));
+    if (-1 == index || !checkSegmentStatus(index)) {
+        return;
+    }
+
+    if (!writeSegmentData(m_segmentList[index])) {
+        return;
+    }
+    Q_EMIT progressChanged(getReceivedBytes(), m_fileSize);
+
+    // 请求到文件末尾的段到达分段终点时主动结束
+    const Segment &segment = m_segmentList.at(index);
+    if (segment.isOpenEnded && -1 != segment.end && segment.end + 1 == segment.offset) {
+        completeSegment(index);
+    }
+}
+
+void PkgDownloadTask::onSegmentFinished()
+{
+    int index = findSegment(qobject_cast<QNetworkReply *>(sender()));
+    if (-1 == index) {
+        return;
+    }
+
+    QNetworkReply *reply = m_segmentList.at(index).reply;
+    if (QNetworkReply::NoError != reply->error()) {
+        const QString err = QString("%1 download failed: %2").arg(m_url).arg(reply->errorString());
+        if (isRetryableError(reply->error())) {
+            retrySegment(index, err);
+        } else {
+            fail(err);
+        }
+        return;
+    }
+    if (!checkSegmentStatus(index) || !writeSegmentData(m_segmentList[index])) {
+        return;
+    }
+
+    completeSegment(index);
+}
+
+QString PkgDownloadTask::getPartFilePath() const
+{
+    return m_filePath + PKG_DOWNLOAD_PART_FILE_SUFFIX;
+}
+
+QString PkgDownloadTask::getStateFilePath() const
+{
+    return m_filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX;
+}
+
+void PkgDownloadTask::loadState()
+{
+    m_completedRangeList.clear();
+    if (!QFile::exists(getStateFilePath()) || !QFileInfo(getPartFilePath()).isFile()) {
+        return;
+    }
+
+    QSettings settings(getStateFilePath(), QSettings::Format::IniFormat);
+    if (m_url != settings.value("url").toString() || m_fileSize != settings.value("fileSize").toLongLong()) {
+        qInfo() << Q_FUNC_INFO << "state of" << m_filePath << "outdated";
+        return;
+    }
+
+    m_etag = settings.value("etag").toString();
+    m_lastModified = settings.value("lastModified").toString();
+    const QStringList rangeStrList = settings.value("ranges").toStringList();
+    for (const QString &rangeStr : rangeStrList) {
+        const QStringList valueList = rangeStr.split("-");
+        if (2 != valueList.size()) {
+            continue;
+        }
+        const qint64 begin = valueList.first().toLongLong();
+        const qint64 end = qMin(valueList.last().toLongLong(), m_fileSize);
+        if (0 <= begin && begin < end) {
+            m_completedRangeList.append(ByteRange(begin, end));
+        }
+    }
+    mergeRangeList(m_completedRangeList);
+    qInfo() << Q_FUNC_INFO << m_filePath << "resume from" << getReceivedBytes() << "/" << m_fileSize;
+}
+
+void PkgDownloadTask::saveState()
+{
+    if (-1 == m_fd || 0 >= m_fileSize) {
+        return;
+    }
+
+    // 状态中记录的范围必须已经落盘
+    ::fdatasync(m_fd);
+    writeState(getCompletedRangeList());
+}
+
+void PkgDownloadTask::saveWrittenBackState()
+{
+    if (-1 == m_fd || 0 >= m_fileSize) {
+        return;
+    }
+
+    // 等待上次发起的回写完成（间隔一秒，通常已经完成），上次的范围即已写入磁盘；同时对当前数据发起回写，不等待
+    const QVector<ByteRange> rangeList = getCompletedRangeList();
+    if (0 != ::sync_file_range(m_fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE)) {
+        qWarning() << Q_FUNC_INFO << "sync_file_range failed:" << strerror(errno);
+        return;
+    }
+    writeState(m_writingBackRangeList);
+    m_writingBackRangeList = rangeList;
+}
+
+void PkgDownloadTask::writeState(const QVector<ByteRange> &rangeList)
+{
+    QStringList rangeStrList;
+    for (const ByteRange &range : rangeList) {
+        rangeStrList.append(QString("%1-%2").arg(range.first).arg(range.second));
+    }
+
+    QSettings settings(getStateFilePath(), QSettings::Format::IniFormat);
+    settings.setValue("url", m_url);
+    settings.setValue("fileSize", m_fileSize);
+    settings.setValue("etag", m_etag);
+    settings.setValue("lastModified", m_lastModified);
+    settings.setValue("ranges", rangeStrList);
+    settings.sync();
+}
+
+void PkgDownloadTask::removeState()
+{
+    QFile::remove(getStateFilePath());
+}
+
+QVector<PkgDownloadTask::ByteRange> PkgDownloadTask::getCompletedRangeList() const
+{
+    QVector<ByteRange> rangeList = m_completedRangeList;
+    for (const Segment &segment : m_segmentList) {
+        if (segment.begin < segment.offset) {
+            rangeList.append(ByteRange(segment.begin, segment.offset));
+        }
+    }
+    mergeRangeList(rangeList);
+    return rangeList;
+}
+
+void PkgDownloadTask::mergeRangeList(QVector<ByteRange> &rangeList)
+{
+    std::sort(rangeList.begin(), rangeList.end());
+    int count = 0;
+    for (const ByteRange &range : rangeList) {
+        if (0 < count && range.first <= rangeList[count - 1].second) {
+            rangeList[count - 1].second = qMax(rangeList[count - 1].second, range.second);
+            continue;
+        }
+        rangeList[count++] = range;
+    }
+    rangeList.resize(count);
+}
+
+bool PkgDownloadTask::prepareFile()
+{
+    // 预先分配文件空间，各段直接写入对应位置
+    if (!allocateFile()) {
+        return false;
+    }
+
+    resetHash();
+    return advanceHash();
+}
+
+bool PkgDownloadTask::allocateFile()
+{
+    // 分配磁盘空间，空间不足时尽早失败，文件系统不支持时只设置大小
+    if (0 != ::fallocate(m_fd, 0, 0, off_t(m_fileSize)) && EOPNOTSUPP != errno && ENOSYS != errno) {
+        fail(QString("allocate %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+        return false;
+    }
+    // 已有的文件比预期大时截短
+    if (0 != ::ftruncate(m_fd, m_fileSize)) {
+        fail(QString("truncate %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void PkgDownloadTask::splitMissingRanges()
+{
+    QVector<ByteRange> missingRangeList;
+    qint64 missingBytes = 0;
+    qint64 begin = 0;
+    for (const ByteRange &range : m_completedRangeList) {
+        if (begin < range.first) {
+            missingRangeList.append(ByteRange(begin, range.first));
+            missingBytes += range.first - begin;
+        }
+        begin = range.second;
+    }
+    if (begin < m_fileSize) {
+        missingRangeList.append(ByteRange(begin, m_fileSize));
+        missingBytes += m_fileSize - begin;
+    }
+
+    // 按缺少的总量均分连接，每段不小于最小段大小
+    const qint64 segmentSize = qMax(qint64(PKG_DOWNLOAD_MIN_SEGMENT_SIZE),
+                                    (missingBytes + m_segmentCount - 1) / m_segmentCount);
+    qInfo() << Q_FUNC_INFO << m_url << "size:" << m_fileSize << "missing:" << missingBytes;
+    m_pendingRangeList.clear();
+    for (const ByteRange &range : missingRangeList) {
+        const qint64 count = qMax(qint64(1), (range.second - range.first) / segmentSize);
+        const qint64 size = (range.second - range.first) / count;
+        for (qint64 i = 0; i < count; ++i) {
+            const qint64 segmentBegin = range.first + i * size;
+            // 最后一段包含余数
+            const qint64 segmentEnd = (count - 1 == i) ? range.second : segmentBegin + size;
+            m_pendingRangeList.append(ByteRange(segmentBegin, segmentEnd));
+        }
+    }
+}
+
+void PkgDownloadTask::startPendingSegments()
+{
+    while (!m_pendingRangeList.isEmpty()) {
+        const ByteRange range = m_pendingRangeList.takeFirst();
+        startSegment(range.first, range.second - 1);
+    }
+}
+
+void PkgDownloadTask::startSegment(qint64 begin, qint64 end)
+{
+    Segment segment;
+    segment.id = ++m_lastSegmentId;
+    segment.begin = begin;
+    segment.end = end;
+    segment.offset = begin;
+    m_segmentList.append(segment);
+    requestSegment(m_segmentList.size() - 1);
+}
+
+void PkgDownloadTask::requestSegment(int index)
+{
+    Segment &segment = m_segmentList[index];
+    QNetworkRequest request(m_resolvedUrl.isEmpty() ? m_url : m_resolvedUrl);
+    // 与原来的HEAD请求一样允许任意重定向，内容由校验值保证
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::UserVerifiedRedirectPolicy);
+
+    // 总是按范围请求，从响应的Content-Range中得到文件大小
+    segment.isOpenEnded = (-1 == segment.end);
+    const QString range = segment.isOpenEnded ? QString("bytes=%1-").arg(segment.offset)
+                                              : QString("bytes=%1-%2").arg(segment.offset).arg(segment.end);
+    request.setRawHeader("Range", range.toUtf8());
+    // 文件已变化时服务器返回整个文件
+    if (!m_etag.isEmpty() && !m_etag.startsWith("W/")) {
+        request.setRawHeader("If-Range", m_etag.toUtf8());
+    } else if (!m_lastModified.isEmpty()) {
+        request.setRawHeader("If-Range", m_lastModified.toUtf8());
+    }
+
+    // https需要的配置（http不需要）
+    QSslConfiguration sslConf = request.sslConfiguration();
+    sslConf.setPeerVerifyMode(QSslSocket::VerifyNone);
+    request.setSslConfiguration(sslConf);
+
+    segment.isStatusChecked = false;
+    segment.reply = m_netManager->get(request);
+    connect(segment.reply, &QNetworkReply::redirected, segment.reply, &QNetworkReply::redirectAllowed);
+    connect(segment.reply, &QNetworkReply::readyRead, this, &PkgDownloadTask::onSegmentReadyRead);
+    connect(segment.reply, &QNetworkReply::finished, this, &PkgDownloadTask::onSegmentFinished);
+}
+
+void PkgDownloadTask::restartDownload()
+{
+    qInfo() << Q_FUNC_INFO << m_url << "size:" << m_fileSize;
+    abortSegments();
+    m_segmentList.clear();
+    m_completedRangeList.clear();
+    m_writingBackRangeList.clear();
+    m_pendingRangeList.clear();
+    if (0 >= m_fileSize) {
+        resetHash();
+        startSegment(0, -1);
+        return;
+    }
+
+    if (!prepareFile()) {
+        return;
+    }
+    // 已得到重定向后的地址，直接并行请求各段
+    splitMissingRanges();
+    startPendingSegments();
+}
+
+void PkgDownloadTask::restartWithSingleSegment()
+{
+    qInfo() << Q_FUNC_INFO << m_url;
+    abortSegments();
+    m_segmentList.clear();
+    m_completedRangeList.clear();
+    m_writingBackRangeList.clear();
+    m_pendingRangeList.clear();
+    resetHash();
+    startSegment(0, -1);
+}
+
+int PkgDownloadTask::findSegment(QNetworkReply *reply) const
+{
+    if (!reply) {
+        return -1;
+    }
+
+    for (int i = 0; i < m_segmentList.size(); ++i) {
+        if (reply == m_segmentList.at(i).reply) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int PkgDownloadTask::findSegmentById(int segmentId) const
+{
+    for (int i = 0; i < m_segmentList.size(); ++i) {
+        if (segmentId == m_segmentList.at(i).id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool PkgDownloadTask::checkSegmentStatus(int &index)
+{
+    Segment &segment = m_segmentList[index];
+    if (segment.isStatusChecked) {
+        return true;
+    }
+    segment.isStatusChecked = true;
+
+    QNetworkReply *reply = segment.reply;
+    const bool isChanged = updateValidator(reply);
+    // 之后的请求直接使用重定向后的地址
+    m_resolvedUrl = reply->url().toString();
+
+    // 206表示按范围返回
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (206 == statusCode && !isChanged) {
+        m_isRangeSupported = true;
+        // Content-Range: bytes 0-1023/4096
+        const QString contentRange = QString::fromLatin1(reply->rawHeader("Content-Range"));
+        const qint64 totalSize = contentRange.section("/", -1).toLongLong();
+        if (0 < totalSize && totalSize != m_fileSize) {
+            // 与预期大小不一致时以服务器为准，已下载的数据作废
+            if (0 < m_fileSize) {
+                qInfo() << Q_FUNC_INFO << m_url << "size changed:" << m_fileSize << "->" << totalSize;
+                m_fileSize = totalSize;
+                restartDownload();
+                return false;
+            }
+
+            // 得到大小后分段，本段截短为第一段
+            m_fileSize = totalSize;
+            if (!prepareFile()) {
+                return false;
+            }
+            splitMissingRanges();
+            m_segmentList[index].end = m_pendingRangeList.takeFirst().second - 1;
+        }
+        startPendingSegments();
+        return true;
+    }
+
+    // 已下载的数据作废
+    m_completedRangeList.clear();
+    m_writingBackRangeList.clear();
+    m_pendingRangeList.clear();
+    resetHash();
+    if (206 == statusCode) {
+        qInfo() << Q_FUNC_INFO << m_url << "changed on server, restart";
+        restartDownload();
+        return false;
+    }
+
+    if (200 != statusCode) {
+        fail(QString("%1 unexpected status code %2").arg(m_url).arg(statusCode));
+        return false;
+    }
+
+    // 返回整个文件时，第一段直接接收全部数据，其他段放弃
+    if (0 == segment.begin) {
+        m_isRangeSupported = false;
+        for (int i = m_segmentList.size() - 1; 0 <= i; --i) {
+            if (i == index) {
+                continue;
+            }
+            QNetworkReply *otherReply = m_segmentList.at(i).reply;
+            if (otherReply) {
+                otherReply->disconnect(this);
+                otherReply->abort();
+                otherReply->deleteLater();
+            }
+            m_segmentList.remove(i);
+        }
+        index = 0;
+        Segment &singleSegment = m_segmentList[index];
+        singleSegment.end = -1;
+        singleSegment.offset = 0;
+        singleSegment.isOpenEnded = true;
+
+        // 大小以Content-Length为准，没有时下载到连接结束
+        const qint64 contentLength = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        m_fileSize = (0 < contentLength) ? contentLength : -1;
+        if (0 < m_fileSize && !allocateFile()) {
+            return false;
+        }
+        qInfo() << Q_FUNC_INFO << m_url << "range requests not supported, use single connection";
+        return true;
+    }
+
+    // 支持范围请求的服务器对后面的段返回200，说明If-Range不匹配，文件已变化，重新分段下载；
+    // 不支持时第一段重新请求整个文件时会改为单连接
+    if (m_isRangeSupported) {
+        qInfo() << Q_FUNC_INFO << m_url << "changed on server, restart";
+        restartDownload();
+        return false;
+    }
+    restartWithSingleSegment();
+    return false;
+}
+
+bool PkgDownloadTask::updateValidator(QNetworkReply *reply)
+{
+    const QString etag = QString::fromLatin1(reply->rawHeader("ETag"));
+    const QString lastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+    const bool isChanged = (!m_etag.isEmpty() && !etag.isEmpty() && m_etag != etag)
+                           || (!m_lastModified.isEmpty() && !lastModified.isEmpty() && m_lastModified != lastModified);
+    if (!etag.isEmpty()) {
+        m_etag = etag;
+    }
+    if (!lastModified.isEmpty()) {
+        m_lastModified = lastModified;
+    }
+    return isChanged;
+}
+
+bool PkgDownloadTask::writeSegmentData(Segment &segment)
+{
+    // 用固定大小的缓冲区分块读取，不为每次收到的数据分配内存
+    while (0 < segment.reply->bytesAvailable()) {
+        qint64 readSize = qMin(qint64(m_readBuffer.size()), segment.reply->bytesAvailable());
+        // 请求到文件末尾的段只写到本段终点
+        if (-1 != segment.end) {
+            readSize = qMin(readSize, segment.end + 1 - segment.offset);
+        }
+        if (0 >= readSize) {
+            break;
+        }
+        readSize = segment.reply->read(m_readBuffer.data(), readSize);
+        if (0 >= readSize) {
+            break;
+        }
+
+        qint64 writtenSize = 0;
+        while (writtenSize < readSize) {
+            const ssize_t size = ::pwrite(m_fd, m_readBuffer.constData() + writtenSize, size_t(readSize - writtenSize),
+                                          off_t(segment.offset + writtenSize));
+            if (-1 == size) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                fail(QString("write %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+                return false;
+            }
+            writtenSize += size;
+        }
+
+        // 紧接已校验部分的数据直接计算
+        if (m_hash && segment.offset == m_hashedOffset) {
+            m_hash->addData(m_readBuffer.constData(), int(readSize));
+            m_hashedOffset += readSize;
+        }
+        segment.offset += readSize;
+    }
+    return true;
+}
+
+void PkgDownloadTask::completeSegment(int index)
+{
+    Segment &segment = m_segmentList[index];
+    QNetworkReply *reply = segment.reply;
+    segment.reply = nullptr;
+    segment.isFinished = true;
+    if (reply) {
+        reply->disconnect(this);
+        if (!reply->isFinished()) {
+            reply->abort();
+        }
+        reply->deleteLater();
+    }
+
+    // 连接提前断开
+    const qint64 expectedEnd = (-1 == segment.end) ? m_fileSize : segment.end + 1;
+    if (0 < expectedEnd && expectedEnd != segment.offset) {
+        retrySegment(index, QString("%1 segment %2-%3 incomplete").arg(m_url).arg(segment.begin).arg(expectedEnd - 1));
+        return;
+    }
+    // 大小未知时以实际收到的为准
+    if (0 >= m_fileSize) {
+        m_fileSize = segment.offset;
+    }
+
+    // 已校验部分可能与后一段已写入的数据相连
+    if (!advanceHash()) {
+        return;
+    }
+
+    tryFinish();
+}
+
+void PkgDownloadTask::retrySegment(int index, const QString &err)
+{
+    Segment &segment = m_segmentList[index];
+    if (segment.reply) {
+        segment.reply->disconnect(this);
+        if (!segment.reply->isFinished()) {
+            segment.reply->abort();
+        }
+        segment.reply->deleteLater();
+        segment.reply = nullptr;
+    }
+    segment.isFinished = false;
+
+    if (PKG_DOWNLOAD_MAX_RETRY_COUNT <= segment.retryCount) {
+        fail(err);
+        return;
+    }
+    ++segment.retryCount;
+
+    // 不支持范围请求时只能从头开始
+    if (!m_isRangeSupported) {
+        segment.offset = segment.begin;
+        m_completedRangeList.clear();
+        m_writingBackRangeList.clear();
+        resetHash();
+    }
+
+    qWarning() << Q_FUNC_INFO << err << "retry" << segment.retryCount << "from" << segment.offset;
+    const int segmentId = segment.id;
+    QTimer::singleShot(PKG_DOWNLOAD_RETRY_INTERVAL_MS * segment.retryCount, this, [this, segmentId] {
+        const int segmentIndex = findSegmentById(segmentId);
+        // 等待期间任务已中止或已重新分段
+        if (!m_isRunning || -1 == segmentIndex) {
+            return;
+        }
+        requestSegment(segmentIndex);
+    });
+}
+
+bool PkgDownloadTask::isRetryableError(int error)
+{
+    // 网络层错误和服务器临时错误可重试，内容错误（如404）重试无意义
+    return (QNetworkReply::NoError < error && error < QNetworkReply::ProxyConnectionRefusedError)
+           || (QNetworkReply::InternalServerError <= error && error <= QNetworkReply::UnknownServerError);
+}
+
+qint64 PkgDownloadTask::getReceivedBytes() const
+{
+    qint64 receivedBytes = 0;
+    for (const ByteRange &range : m_completedRangeList) {
+        receivedBytes += range.second - range.first;
+    }
+    for (const Segment &segment : m_segmentList) {
+        receivedBytes += segment.offset - segment.begin;
+    }
+    return receivedBytes;
+}
+
+void PkgDownloadTask::abortSegments()
+{
+    for (Segment &segment : m_segmentList) {
+        if (!segment.reply) {
+            continue;
+        }
+        // 先断开连接，避免中止时再进入完成处理
+        segment.reply->disconnect(this);
+        segment.reply->abort();
+        segment.reply->deleteLater();
+        segment.reply = nullptr;
+    }
+}
+
+void PkgDownloadTask::resetHash()
+{
+    m_hashedOffset = 0;
+    if (m_hash) {
+        m_hash->reset();
+    }
+}
+
+bool PkgDownloadTask::advanceHash()
+{
+    if (!m_hash) {
+        return true;
+    }
+
+    qint64 endOffset = m_hashedOffset;
+    for (const ByteRange &range : getCompletedRangeList()) {
+        if (range.first <= m_hashedOffset && m_hashedOffset < range.second) {
+            endOffset = range.second;
+            break;
+        }
+    }
+    if (m_hashedOffset >= endOffset) {
+        return true;
+    }
+
+    // 每次只补算有限的数据，其余在之后的事件循环中继续，不阻塞其他下载
+    const qint64 stepEndOffset = qMin(endOffset, m_hashedOffset + qint64(PKG_DOWNLOAD_HASH_READ_SIZE) * PKG_DOWNLOAD_HASH_STEP_BLOCK_COUNT);
+    QByteArray buffer(PKG_DOWNLOAD_HASH_READ_SIZE, Qt::Uninitialized);
+    while (m_hashedOffset < stepEndOffset) {
+        const ssize_t size = ::pread(m_fd, buffer.data(), size_t(qMin(qint64(buffer.size()), stepEndOffset - m_hashedOffset)),
+                                     off_t(m_hashedOffset));
+        if (-1 == size && EINTR == errno) {
+            continue;
+        }
+        if (0 >= size) {
+            fail(QString("read %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+            return false;
+        }
+        m_hash->addData(buffer.constData(), int(size));
+        m_hashedOffset += size;
+    }
+
+    if (m_hashedOffset < endOffset) {
+        m_hashTimer->start();
+    }
+    return true;
+}
+
+bool PkgDownloadTask::verifyChecksum()
+{
+    if (!m_hash) {
+        return true;
+    }
+
+    const QString checksum = QString::fromLatin1(m_hash->result().toHex());
+    if (m_checksum == checksum) {
+        return true;
+    }
+
+    // 数据已损坏，不再续传
+    qWarning() << Q_FUNC_INFO << m_url << "expected:" << m_checksum << "actual:" << checksum;
+    fail(QString("%1 checksum mismatch").arg(m_url));
+    QFile::remove(getPartFilePath());
+    removeState();
+    return false;
+}
+
+void PkgDownloadTask::onHashTimerTimeout()
+{
+    if (!m_isRunning || !advanceHash()) {
+        return;
+    }
+
+    tryFinish();
+}
+
+void PkgDownloadTask::tryFinish()
+{
+    if (!m_pendingRangeList.isEmpty()) {
+        return;
+    }
+    for (const Segment &segment : m_segmentList) {
+        if (!segment.isFinished) {
+            return;
+        }
+    }
+    // 校验值补算完成后再结束，补算完成时会再次检查
+    if (m_hash && m_hashedOffset < m_fileSize) {
+        return;
+    }
+
+    finish();
+}
+
+void PkgDownloadTask::finish()
+{
+    if (!verifyChecksum()) {
+        return;
+    }
+
+    m_isRunning = false;
+    m_saveStateTimer->stop();
+    m_hashTimer->stop();
+    // 只把本文件落盘后再重命名，重命名后的文件内容完整
+    if (0 != ::fdatasync(m_fd)) {
+        fail(QString("sync %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+        return;
+    }
+    closeFile();
+
+    if (0 != ::rename(getPartFilePath().toLocal8Bit().constData(), m_filePath.toLocal8Bit().constData())) {
+        fail(QString("rename %1 failed: %2").arg(getPartFilePath()).arg(strerror(errno)));
+        return;
+    }
+    removeState();
+
+    Q_EMIT progressChanged(getReceivedBytes(), m_fileSize);
+    Q_EMIT finished();
+}
+
+void PkgDownloadTask::fail(const QString &err)
+{
+    qWarning() << Q_FUNC_INFO << err;
+    // 保留已完成的范围，下次续传
+    m_isRunning = false;
+    m_saveStateTimer->stop();
+    m_hashTimer->stop();
+    saveState();
+    abortSegments();
+    closeFile();
+    Q_EMIT failed(err);
+}
+
+void PkgDownloadTask::closeFile()
+{
+    if (-1 == m_fd) {
+        return;
+    }
+    ::close(m_fd);
+    m_fd = -1;
+}
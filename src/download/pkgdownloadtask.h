@@ -0,0 +1,186 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+QT_END_NAMESPACE
+
+// 默认分段数，即并行连接数
+#define PKG_DOWNLOAD_SEGMENT_COUNT 4
+// 每段最小字节数，文件较小时减少分段
+#define PKG_DOWNLOAD_MIN_SEGMENT_SIZE (1024 * 1024)
+// 未完成的下载文件后缀
+#define PKG_DOWNLOAD_PART_FILE_SUFFIX ".part"
+// 下载状态文件后缀，记录地址、校验标识和已完成的范围
+#define PKG_DOWNLOAD_STATE_FILE_SUFFIX ".part.state"
+// 下载状态保存间隔（毫秒）
+#define PKG_DOWNLOAD_STATE_SAVE_INTERVAL_MS 1000
+// 补算校验值时每次读取的字节数
+#define PKG_DOWNLOAD_HASH_READ_SIZE (256 * 1024)
+// 每次事件循环中补算校验值的最大块数
+#define PKG_DOWNLOAD_HASH_STEP_BLOCK_COUNT 4
+// 每段网络错误时的最大重试次数
+#define PKG_DOWNLOAD_MAX_RETRY_COUNT 3
+// 重试间隔（毫秒），按重试次数递增
+#define PKG_DOWNLOAD_RETRY_INTERVAL_MS 1000
+// 读取响应数据的缓冲区大小，每个任务一个，重复使用
+#define PKG_DOWNLOAD_READ_BUFFER_SIZE (64 * 1024)
+
+// 安装包下载任务
+// 文件按字节范围分成多段，每段一个连接并行下载，各段数据用pwrite直接写入预先设置好大小的文件中的对应位置，
+// 进度为各段之和；服务器不支持范围请求（返回200）时，改为单连接下载整个文件
+// 不预先发送HEAD请求：先只请求第一段，从其响应中得到文件大小（Content-Range）和重定向后的地址，
+// 再用该地址并行请求其他段；大小未知时第一段请求到文件末尾，得到大小后截短为第一段，收到首个字节即开始计算进度
+// 大小已知时用fallocate预先分配空间；响应数据经固定大小的缓冲区读出后写入，完成时只对本文件fdatasync再重命名
+// 下载过程中写入.part文件，并定时把已完成的范围记录到状态文件中，中断后再次下载同一文件时只请求缺少的范围，
+// 定时保存时只发起回写（sync_file_range），记录的是上次发起回写、本次等其完成后已落盘的范围，只在中止和失败时同步落盘，
+// 请求带If-Range，服务器上的文件已变化时重新下载；全部完成后重命名为目标文件
+// 设置校验值时边写边算：写入位置正好接着已校验部分的数据直接计算，其他段的数据在前一段完成后从文件（页缓存）中补算，
+// 补算在事件循环中分批进行，每次只读取几块，不阻塞其他下载；全部补算完成时与期望值比较，不一致时删除文件并失败
+// 网络错误时按递增间隔异步重试该段剩余的范围
+class PkgDownloadTask : public QObject
+{
+    Q_OBJECT
+public:
+    // fileSize为预期大小（如仓库索引中的大小），未知时传-1，以服务器响应为准
+    explicit PkgDownloadTask(QNetworkAccessManager *netManager, const QString &url, const QString &filePath,
+                             qint64 fileSize, int segmentCount = PKG_DOWNLOAD_SEGMENT_COUNT, QObject *parent = nullptr);
+    virtual ~PkgDownloadTask() override;
+
+    // 设置期望的校验值（十六进制），需在start前调用
+    void setChecksum(QCryptographicHash::Algorithm algorithm, const QString &checksum);
+
+    void start();
+    // 中止下载，保留.part文件和状态文件以便续传
+    void abort();
+
+    QString getUrl() const;
+    QString getFilePath() const;
+
+Q_SIGNALS:
+    void progressChanged(qint64 bytesReceived, qint64 bytesTotal);
+    void finished();
+    void failed(const QString &err);
+
+private Q_SLOTS:
+    void onSegmentReadyRead();
+    void onSegmentFinished();
+    // 继续补算校验值
+    void onHashTimerTimeout();
+
+private:
+    // 字节范围[first, second)
+    typedef QPair<qint64, qint64> ByteRange;
+
+    struct Segment {
+        int id; // 重试时用于查找
+        QNetworkReply *reply; // 等待重试时为空
+        qint64 begin; // 范围起点
+        qint64 end; // 范围终点（包含），-1表示到文件末尾
+        qint64 offset; // 下一个写入位置
+        bool isOpenEnded; // 请求是否到文件末尾，到达end时需主动结束
+        bool isStatusChecked; // 是否已检查响应状态码
+        bool isFinished;
+        int retryCount;
+        Segment()
+        {
+            id = -1;
+            reply = nullptr;
+            begin = 0;
+            end = -1;
+            offset = 0;
+            isOpenEnded = false;
+            isStatusChecked = false;
+            isFinished = false;
+            retryCount = 0;
+        }
+    };
+
+    QString getPartFilePath() const;
+    QString getStateFilePath() const;
+    // 读取状态文件，地址和大小一致时恢复已完成的范围
+    void loadState();
+    // 先把已写入的数据落盘，再记录已完成的范围，中止和失败时调用
+    void saveState();
+    // 定时保存：等上次发起的回写完成后记录上次的范围，再对当前已写入的数据发起回写，下次保存时记录
+    void saveWrittenBackState();
+    void writeState(const QVector<ByteRange> &rangeList);
+    void removeState();
+    // 已完成的范围，包括正在下载的各段已写入的部分
+    QVector<ByteRange> getCompletedRangeList() const;
+    static void mergeRangeList(QVector<ByteRange> &rangeList);
+
+    // 大小已知后设置文件大小，并补算已完成的开头部分的校验值
+    bool prepareFile();
+    // 按m_fileSize分配磁盘空间并设置文件大小
+    bool allocateFile();
+    // 把缺少的范围分段，放入待下载列表
+    void splitMissingRanges();
+    // 开始下载待下载列表中的各段
+    void startPendingSegments();
+    // 请求[begin, end]范围的数据，end为-1时请求到文件末尾
+    void startSegment(qint64 begin, qint64 end);
+    // 从段的当前位置请求剩余数据
+    void requestSegment(int index);
+    // 丢弃已下载的数据，按大小重新分段下载
+    void restartDownload();
+    // 丢弃已下载的数据，改为单连接下载整个文件
+    void restartWithSingleSegment();
+    int findSegment(QNetworkReply *reply) const;
+    int findSegmentById(int segmentId) const;
+    // 检查响应状态码，服务器不支持范围请求或文件已变化时切换下载方式，返回false表示该段已放弃
+    // 改为单连接时该段下标可能变化，通过index返回
+    bool checkSegmentStatus(int &index);
+    // 记录响应中的ETag和Last-Modified，续传时用于If-Range，返回文件是否已变化
+    bool updateValidator(QNetworkReply *reply);
+    bool writeSegmentData(Segment &segment);
+    // 段已下载完成，全部完成时结束任务
+    void completeSegment(int index);
+    // 网络错误时延后重试，超过次数时失败
+    void retrySegment(int index, const QString &err);
+    static bool isRetryableError(int error);
+    qint64 getReceivedBytes() const;
+    void abortSegments();
+    // 已下载的数据作废时重新计算校验值
+    void resetHash();
+    // 从文件中补算已校验部分之后连续已完成的数据，每次最多PKG_DOWNLOAD_HASH_STEP_BLOCK_COUNT块，未完成时定时继续
+    bool advanceHash();
+    bool verifyChecksum();
+    // 各段都已完成且校验值已补算完成时结束任务
+    void tryFinish();
+    void finish();
+    void fail(const QString &err);
+    void closeFile();
+
+private:
+    QNetworkAccessManager *m_netManager;
+    QString m_url;
+    QString m_resolvedUrl; // 重定向后的地址，之后的请求直接使用
+    QString m_filePath;
+    qint64 m_fileSize;
+    int m_segmentCount;
+    int m_fd;
+    bool m_isRunning;
+    bool m_isRangeSupported; // 服务器是否支持范围请求，不支持时重试只能从头开始
+    int m_lastSegmentId;
+    QString m_etag;
+    QString m_lastModified;
+    QVector<ByteRange> m_completedRangeList; // 续传前已完成的范围
+    QVector<ByteRange> m_pendingRangeList; // 等待第一段响应后再请求的范围
+    QVector<ByteRange> m_writingBackRangeList; // 上次定时保存时已写入并发起回写的范围
+    QVector<Segment> m_segmentList;
+    QTimer *m_saveStateTimer;
+    QTimer *m_hashTimer; // 分批补算校验值
+    QCryptographicHash *m_hash; // 未设置校验值时为空
+    QString m_checksum;
+    qint64 m_hashedOffset; // [0, m_hashedOffset)已计入校验值
+    QByteArray m_readBuffer; // 各段共用的读取缓冲区
+};
@@ -0,0 +1,203 @@
+#include "pkgfilecache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace AM;
+
+QString PkgFileCache::findPkgFile(const PkgInfo &info, const QStringList &dirPathList)
+{
+    const QStringList fileNameList = getPkgFileNameList(info);
+    for (const QString &dirPath : dirPathList) {
+        for (const QString &fileName : fileNameList) {
+            const QString filePath = QString("%1/%2").arg(dirPath).arg(fileName);
+            if (isPkgFileMatched(info, filePath)) {
+                return filePath;
+            }
+        }
+    }
+    return QString();
+}
+
+bool PkgFileCache::isPkgFileMatched(const PkgInfo &info, const QString &filePath)
+{
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) {
+        return false;
+    }
+
+    // 大小不同时不必计算校验值
+    if (0 < info.pkgSize && info.pkgSize != fileInfo.size()) {
+        return false;
+    }
+
+    QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha256;
+    QString checksum = info.sha256;
+    if (checksum.isEmpty()) {
+        algorithm = QCryptographicHash::Md5;
+        checksum = info.md5sum;
+    }
+    // 只有大小一致不能确定是同一安装包，如本地重新打包的文件
+    if (checksum.isEmpty()) {
+        return false;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::OpenModeFlag::ReadOnly)) {
+        return false;
+    }
+    QCryptographicHash hash(algorithm);
+    if (!hash.addData(&file)) {
+        return false;
+    }
+    const bool isMatched = (checksum.trimmed().toLower() == QString::fromLatin1(hash.result().toHex()));
+    if (!isMatched) {
+        qInfo() << Q_FUNC_INFO << filePath << "checksum mismatch";
+    }
+    return isMatched;
+}
+
+bool PkgFileCache::cloneFile(const QString &srcFilePath, const QString &dstFilePath)
+{
+    const QByteArray srcPath = srcFilePath.toLocal8Bit();
+    const QByteArray dstPath = dstFilePath.toLocal8Bit();
+    const QByteArray tmpPath = (dstFilePath + PKG_FILE_CACHE_TMP_FILE_SUFFIX).toLocal8Bit();
+    ::unlink(tmpPath.constData());
+
+    const int srcFd = ::open(srcPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (-1 == srcFd) {
+        qWarning() << Q_FUNC_INFO << "open" << srcFilePath << "failed:" << strerror(errno);
+        return false;
+    }
+
+    int dstFd = ::open(tmpPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool isCloned = false;
+    // 同一文件系统支持时共享数据块，不复制数据
+    if (-1 != dstFd && 0 == ::ioctl(dstFd, FICLONE, srcFd)) {
+        qInfo() << Q_FUNC_INFO << srcFilePath << "reflinked";
+        isCloned = true;
+    }
+
+    // 硬链接，安装包文件不会被修改
+    if (!isCloned) {
+        if (-1 != dstFd) {
+            ::close(dstFd);
+            ::unlink(tmpPath.constData());
+        }
+        if (0 == ::link(srcPath.constData(), tmpPath.constData())) {
+            qInfo() << Q_FUNC_INFO << srcFilePath << "hard linked";
+            ::close(srcFd);
+            if (0 != ::rename(tmpPath.constData(), dstPath.constData())) {
+                ::unlink(tmpPath.constData());
+                return false;
+            }
+            return true;
+        }
+        dstFd = ::open(tmpPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+
+    if (!isCloned && -1 != dstFd) {
+        isCloned = copyFileContent(srcFd, dstFd);
+    }
+
+    ::close(srcFd);
+    if (-1 == dstFd) {
+        qWarning() << Q_FUNC_INFO << "open" << tmpPath << "failed:" << strerror(errno);
+        return false;
+    }
+    ::close(dstFd);
+
+    if (!isCloned || 0 != ::rename(tmpPath.constData(), dstPath.constData())) {
+        qWarning() << Q_FUNC_INFO << srcFilePath << "copy failed";
+        ::unlink(tmpPath.constData());
+        return false;
+    }
+    return true;
+}
+
+QString PkgFileCache::reusePkgFile(const PkgInfo &info, const QStringList &dirPathList, const QString &filePath)
+{
+    const QString cachedFilePath = findPkgFile(info, dirPathList);
+    if (cachedFilePath.isEmpty()) {
+        return QString();
+    }
+    if (filePath != cachedFilePath && !cloneFile(cachedFilePath, filePath)) {
+        return QString();
+    }
+    return cachedFilePath;
+}
+
+QStringList PkgFileCache::getPkgFileNameList(const PkgInfo &info)
+{
+    QStringList fileNameList;
+    fileNameList.append(QString(PKG_NAME_FORMAT_STR).arg(info.pkgName).arg(info.version).arg(info.arch));
+    if (info.version.contains(":")) {
+        QString version = info.version;
+        version.replace(":", "%3a");
+        fileNameList.append(QString(PKG_NAME_FORMAT_STR).arg(info.pkgName).arg(version).arg(info.arch));
+    }
+    return fileNameList;
+}
+
+bool PkgFileCache::copyFileContent(int srcFd, int dstFd)
+{
+    // 内核中复制，不经过用户空间
+    qint64 copiedSize = 0;
+    while (true) {
+        const ssize_t size = ::copy_file_range(srcFd, nullptr, dstFd, nullptr, 1024 * 1024 * 1024, 0);
+        if (0 == size) {
+            qInfo() << Q_FUNC_INFO << "copied with copy_file_range";
+            return true;
+        }
+        if (0 < size) {
+            copiedSize += size;
+            continue;
+        }
+        if (EINTR == errno) {
+            continue;
+        }
+        // 跨文件系统或不支持时，从头普通复制
+        if (0 == copiedSize && (EXDEV == errno || ENOSYS == errno || EINVAL == errno || EOPNOTSUPP == errno)) {
+            break;
+        }
+        return false;
+    }
+
+    if (0 != ::lseek(srcFd, 0, SEEK_SET) || 0 != ::lseek(dstFd, 0, SEEK_SET)) {
+        return false;
+    }
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    while (true) {
+        const ssize_t readSize = ::read(srcFd, buffer.data(), size_t(buffer.size()));
+        if (0 == readSize) {
+            return true;
+        }
+        if (-1 == readSize) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        ssize_t writtenSize = 0;
+        while (writtenSize < readSize) {
+            const ssize_t size = ::write(dstFd, buffer.constData() + writtenSize, size_t(readSize - writtenSize));
+            if (-1 == size) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            writtenSize += size;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../common/appmanagercommon.h"
+
+#include <QString>
+#include <QStringList>
+
+// apt下载的安装包缓存目录
+#define APT_ARCHIVES_DIR_PATH "/var/cache/apt/archives"
+// 复制时的临时文件后缀
+#define PKG_FILE_CACHE_TMP_FILE_SUFFIX ".cache-tmp"
+
+// 本地安装包查找
+// 按包名、版本、架构在若干目录中查找同一安装包，大小和校验值都与仓库索引一致才可用；
+// 找到后复制到下载目录，依次尝试reflink、硬链接、copy_file_range，都不支持时普通读写复制
+class PkgFileCache
+{
+public:
+    // 在dirPathList中查找与info一致的安装包，找不到时返回空
+    static QString findPkgFile(const AM::PkgInfo &info, const QStringList &dirPathList);
+    // 校验文件大小和校验值，info中没有校验值时视为不一致
+    static bool isPkgFileMatched(const AM::PkgInfo &info, const QString &filePath);
+    // 复制文件，先写入临时文件再重命名，目标文件已存在时覆盖
+    static bool cloneFile(const QString &srcFilePath, const QString &dstFilePath);
+    // 查找同一安装包并复制到filePath，返回找到的文件路径，未找到或复制失败时返回空
+    // 需读取整个文件计算校验值，耗时较长，应在线程池中调用
+    static QString reusePkgFile(const AM::PkgInfo &info, const QStringList &dirPathList, const QString &filePath);
+
+private:
+    // 各目录中可能的文件名，apt缓存中版本号的":"转义为"%3a"
+    static QStringList getPkgFileNameList(const AM::PkgInfo &info);
+    static bool copyFileContent(int srcFd, int dstFd);
+};
@@ -0,0 +1,267 @@
+#include "filelistmodel.h"
+
+#include <algorithm>
+
+// 根节点id
+#define FILE_LIST_ROOT_NODE_ID 0
+
+FileListModel::FileListModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , m_dirIcon(QIcon::fromTheme("folder"))
+    , m_fileIcon(QIcon::fromTheme("text-x-generic"))
+{
+    m_nodeList.append(Node());
+}
+
+FileListModel::~FileListModel()
+{
+}
+
+QModelIndex FileListModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (0 != column || 0 > row) {
+        return QModelIndex();
+    }
+
+    const Node &parentNode = m_nodeList.at(getNodeId(parent));
+    if (row >= parentNode.children.size()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(parentNode.children.at(row)));
+}
+
+QModelIndex FileListModel::parent(const QModelIndex &child) const
+{
+    const int nodeId = getNodeId(child);
+    const int parentId = m_nodeList.at(nodeId).parent;
+    if (FILE_LIST_ROOT_NODE_ID == nodeId || FILE_LIST_ROOT_NODE_ID == parentId) {
+        return QModelIndex();
+    }
+    return createIndex(m_nodeList.at(parentId).row, 0, quintptr(parentId));
+}
+
+int FileListModel::rowCount(const QModelIndex &parent) const
+{
+    if (0 < parent.column()) {
+        return 0;
+    }
+    return m_nodeList.at(getNodeId(parent)).children.size();
+}
+
+int FileListModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return 1;
+}
+
+QVariant FileListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const Node &node = m_nodeList.at(getNodeId(index));
+    const QString &firstPath = m_filePathList.at(node.begin);
+    const int parentPrefixLength = m_nodeList.at(node.parent).prefixLength;
+    switch (role) {
+    case Qt::DisplayRole:
+        // 跳过父路径后的目录分隔符
+        return firstPath.mid(parentPrefixLength + 1, node.prefixLength - parentPrefixLength - 1);
+    case Qt::ToolTipRole:
+        return firstPath.left(node.prefixLength);
+    case Qt::DecorationRole:
+        return isNodeHasChildren(node) ? m_dirIcon : m_fileIcon;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+bool FileListModel::hasChildren(const QModelIndex &parent) const
+{
+    if (0 < parent.column()) {
+        return false;
+    }
+    return isNodeHasChildren(m_nodeList.at(getNodeId(parent)));
+}
+
+bool FileListModel::canFetchMore(const QModelIndex &parent) const
+{
+    const Node &node = m_nodeList.at(getNodeId(parent));
+    return !node.isFetched && isNodeHasChildren(node);
+}
+
+void FileListModel::fetchMore(const QModelIndex &parent)
+{
+    fetchChildren(getNodeId(parent));
+}
+
+void FileListModel::setFilePathList(const QStringList &filePathList)
+{
+    beginResetModel();
+    m_filePathList = filePathList;
+    // dpkg列表中的根目录"/."不显示
+    m_filePathList.removeAll("/.");
+    m_filePathList.removeAll("/");
+    if (!std::is_sorted(m_filePathList.cbegin(), m_filePathList.cend(), isFilePathLessThan)) {
+        sortFilePathList(m_filePathList);
+    }
+
+    m_nodeList.clear();
+    Node rootNode;
+    rootNode.end = m_filePathList.size();
+    m_nodeList.append(rootNode);
+    endResetModel();
+
+    // 第一层节点直接生成
+    fetchChildren(FILE_LIST_ROOT_NODE_ID);
+}
+
+void FileListModel::sortFilePathList(QStringList &filePathList)
+{
+    std::sort(filePathList.begin(), filePathList.end(), isFilePathLessThan);
+}
+
+bool FileListModel::isFilePathLessThan(const QString &a, const QString &b)
+{
+    const int length = qMin(a.size(), b.size());
+    for (int i = 0; i < length; ++i) {
+        const ushort charA = a.at(i).unicode();
+        const ushort charB = b.at(i).unicode();
+        if (charA == charB) {
+            continue;
+        }
+
+        // 目录分隔符排在最前，保证目录及其下全部路径连续
+        if ('/' == charA) {
+            return true;
+        }
+        if ('/' == charB) {
+            return false;
+        }
+        return charA < charB;
+    }
+    return a.size() < b.size();
+}
+
+const QStringList &FileListModel::getFilePathList() const
+{
+    return m_filePathList;
+}
+
+QVector<int> FileListModel::findPaths(const QStringList &filePathList, const QString &text)
+{
+    QVector<int> pathIndexList;
+    if (text.isEmpty()) {
+        return pathIndexList;
+    }
+
+    for (int i = 0; i < filePathList.size(); ++i) {
+        if (filePathList.at(i).contains(text, Qt::CaseInsensitive)) {
+            pathIndexList.append(i);
+        }
+    }
+    return pathIndexList;
+}
+
+int FileListModel::getPathIndex(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return -1;
+    }
+    return m_nodeList.at(getNodeId(index)).pathIndex;
+}
+
+QModelIndex FileListModel::getPathModelIndex(int pathIndex)
+{
+    if (0 > pathIndex || pathIndex >= m_filePathList.size()) {
+        return QModelIndex();
+    }
+
+    int nodeId = FILE_LIST_ROOT_NODE_ID;
+    while (true) {
+        fetchChildren(nodeId);
+        // 子节点范围按顺序排列，二分查找包含该路径的子节点
+        const QVector<int> &children = m_nodeList.at(nodeId).children;
+        QVector<int>::const_iterator cIter = std::upper_bound(children.cbegin(), children.cend(), pathIndex,
+                                                              [this](int value, int childId) {
+            return value < m_nodeList.at(childId).begin;
+        });
+        if (children.cbegin() == cIter) {
+            return QModelIndex();
+        }
+
+        const int childId = *(cIter - 1);
+        const Node &child = m_nodeList.at(childId);
+        if (pathIndex >= child.end) {
+            return QModelIndex();
+        }
+        if (pathIndex == child.pathIndex) {
+            return createIndex(child.row, 0, quintptr(childId));
+        }
+        nodeId = childId;
+    }
+}
+
+int FileListModel::getNodeId(const QModelIndex &index) const
+{
+    return index.isValid() ? int(index.internalId()) : FILE_LIST_ROOT_NODE_ID;
+}
+
+bool FileListModel::isNodeHasChildren(const Node &node) const
+{
+    return node.end - node.begin > (-1 == node.pathIndex ? 0 : 1);
+}
+
+void FileListModel::fetchChildren(int nodeId)
+{
+    if (m_nodeList.at(nodeId).isFetched) {
+        return;
+    }
+    m_nodeList[nodeId].isFetched = true;
+
+    // 复制父节点信息，生成子节点时m_nodeList可能重新分配
+    const Node node = m_nodeList.at(nodeId);
+    QVector<int> children;
+    int pathIndex = (-1 == node.pathIndex) ? node.begin : node.pathIndex + 1;
+    while (pathIndex < node.end) {
+        const QString &path = m_filePathList.at(pathIndex);
+        // 子节点路径：父路径 + "/" + 下一级名称
+        int childPrefixLength = path.indexOf('/', node.prefixLength + 1);
+        if (-1 == childPrefixLength) {
+            childPrefixLength = path.size();
+        }
+        const QStringRef childPrefix = path.leftRef(childPrefixLength);
+
+        // 同一子节点下的路径连续排列，二分查找其范围终点
+        const QStringList::const_iterator endIter = std::partition_point(
+            m_filePathList.cbegin() + pathIndex, m_filePathList.cbegin() + node.end,
+            [&childPrefix, childPrefixLength](const QString &otherPath) {
+            return otherPath.startsWith(childPrefix)
+                    && (otherPath.size() == childPrefixLength || '/' == otherPath.at(childPrefixLength));
+        });
+
+        Node child;
+        child.parent = nodeId;
+        child.row = children.size();
+        child.begin = pathIndex;
+        child.end = int(endIter - m_filePathList.cbegin());
+        child.prefixLength = childPrefixLength;
+        child.pathIndex = (path.size() == childPrefixLength) ? pathIndex : -1;
+        children.append(m_nodeList.size());
+        m_nodeList.append(child);
+
+        pathIndex = child.end;
+    }
+
+    if (children.isEmpty()) {
+        return;
+    }
+
+    const QModelIndex parentIndex = (FILE_LIST_ROOT_NODE_ID == nodeId) ? QModelIndex()
+                                                                       : createIndex(node.row, 0, quintptr(nodeId));
+    beginInsertRows(parentIndex, 0, children.size() - 1);
+    m_nodeList[nodeId].children = children;
+    endInsertRows();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QIcon>
+#include <QStringList>
+#include <QVector>
+
+// 安装文件列表数据模型，按目录分组显示为树
+// 路径按目录分隔符最小的顺序排序后，同一目录下的全部路径连续，
+// 每个节点只记录其子树在路径列表中的范围，展开时才二分查找生成子节点，
+// 文件再多，打开时也只生成第一层节点
+class FileListModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    explicit FileListModel(QObject *parent = nullptr);
+    virtual ~FileListModel() override;
+
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    virtual QModelIndex parent(const QModelIndex &child) const override;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    virtual bool canFetchMore(const QModelIndex &parent) const override;
+    virtual void fetchMore(const QModelIndex &parent) override;
+
+    // 设置文件路径列表，未排序时先排序
+    void setFilePathList(const QStringList &filePathList);
+    // 路径排序，目录分隔符排在其他字符之前，可在工作线程中预先排序
+    static void sortFilePathList(QStringList &filePathList);
+    static bool isFilePathLessThan(const QString &a, const QString &b);
+
+    // 已排序的路径列表，可传给工作线程查找
+    const QStringList &getFilePathList() const;
+    // 查找包含text的全部路径下标，升序，可在工作线程中执行
+    static QVector<int> findPaths(const QStringList &filePathList, const QString &text);
+    // 获取节点对应的路径下标，目录本身不在列表中时返回-1
+    int getPathIndex(const QModelIndex &index) const;
+    // 获取路径对应的节点，按需生成其上层各级节点
+    QModelIndex getPathModelIndex(int pathIndex);
+
+private:
+    struct Node {
+        int parent; // 父节点，根节点为-1
+        int row; // 在父节点中的行
+        int begin; // 子树路径范围起点（包含）
+        int end; // 子树路径范围终点（不包含）
+        int prefixLength; // 节点路径长度，即范围内路径的公共前缀长度
+        int pathIndex; // 节点自身的路径下标，目录本身不在列表中时为-1
+        bool isFetched; // 是否已生成子节点
+        QVector<int> children;
+        Node()
+        {
+            parent = -1;
+            row = 0;
+            begin = 0;
+            end = 0;
+            prefixLength = 0;
+            pathIndex = -1;
+            isFetched = false;
+        }
+    };
+
+    int getNodeId(const QModelIndex &index) const;
+    bool isNodeHasChildren(const Node &node) const;
+    // 生成节点的子节点
+    void fetchChildren(int nodeId);
+
+private:
+    QStringList m_filePathList; // 已排序的路径列表
+    QVector<Node> m_nodeList; // 已生成的节点，0为根节点
+    QIcon m_dirIcon;
+    QIcon m_fileIcon;
+};
@@ -1,16 +1,22 @@
 #include "appmanagerjob.h"
+#include "../download/pkgdownloadmanager.h"
+#include "../download/pkgfilecache.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QProcess>
 #include <QDebug>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QEventLoop>
 #include <QSettings>
 #include <QTextCodec>
 #include <QStandardItem>
 #include <QMimeDatabase>
 #include <QStandardPaths>
+#include <QtConcurrent>
 
 #include <zlib.h>
 #include <aio.h> // async I/O
@@ -226,9 +232,9 @@ AppManagerJob::AppManagerJob(QObject *parent)
     , m_runningStatus(Normal)
     , m_isOnlyLoadCurrentArchAppInfos(false)
     , m_isInitiallized(false)
-    , m_downloadingFile(nullptr)
     , m_netManager(nullptr)
-    , m_netReply(nullptr)
+    , m_downloadManager(nullptr)
+    , m_latestDownloadId(0)
     , m_pkgMonitor(nullptr)
 {
     m_currentCpuArchStr = QSysInfo::currentCpuArchitecture();
@@ -244,6 +250,11 @@ AppManagerJob::AppManagerJob(QObject *parent)
 
 AppManagerJob::~AppManagerJob()
 {
+    // 先于网络管理器析构，中止下载并保存续传状态
+    if (m_downloadManager) {
+        delete m_downloadManager;
+        m_downloadManager = nullptr;
+    }
 }
 
 RunningStatus AppManagerJob::getRunningStatus()
@@ -266,14 +277,14 @@ QMap<QString, AppInfo> AppManagerJob::getAppInfosMap()
     return appInfosMap;
 }
 
-QList<AppInfo> AppManagerJob::getSearchedAppInfoList()
+AppSearchIndex AppManagerJob::getSearchIndex()
 {
-    QList<AppInfo> appInfoList;
+    AppSearchIndex searchIndex;
     m_mutex.lock();
-    appInfoList = m_searchedAppInfoList;
+    searchIndex = m_searchIndex;
     m_mutex.unlock();
 
-    return appInfoList;
+    return searchIndex;
 }
 
 QString AppManagerJob::getDownloadDirPath() const
@@ -286,11 +297,22 @@ QString AppManagerJob::getPkgBuildDirPath() const
     return m_pkgBuildDirPath;
 }
 
+int AppManagerJob::createDownloadId()
+{
+    return m_latestDownloadId.fetchAndAddOrdered(1) + 1;
+}
+
 void AppManagerJob::init()
 {
     reloadAppInfos();
 
     m_netManager = new QNetworkAccessManager(this);
+    // 下载队列
+    m_downloadManager = new PkgDownloadManager(m_netManager, this);
+    connect(m_downloadManager, &PkgDownloadManager::downloadProgressChanged, this, &AppManagerJob::onDownloadProgressChanged);
+    connect(m_downloadManager, &PkgDownloadManager::downloadFinished, this, &AppManagerJob::onFileDownloadFinished);
+    connect(m_downloadManager, &PkgDownloadManager::downloadFailed, this, &AppManagerJob::onFileDownloadFailed);
+    connect(m_downloadManager, &PkgDownloadManager::downloadCanceled, this, &AppManagerJob::onFileDownloadCanceled);
     // 包监视器
     m_pkgMonitor = new PkgMonitor(this);
 
@@ -304,6 +326,7 @@ void AppManagerJob::reloadAppInfos()
     setRunningStatus(AM::Busy);
     m_mutex.lock(); // m_appInfosMap为成员变量，加锁
     m_appInfosMap.clear();
+    m_searchIndex.clear();
     m_mutex.unlock(); // 解锁
 
     reloadSourceUrlList();
@@ -356,145 +379,115 @@ void AppManagerJob::downloadPkg(const QString &pkgName)
     Q_EMIT downloadPkgFinished(pkgName);
 }
 
-void AppManagerJob::downloadPkgFile(const PkgInfo &info)
-{
-    m_downloadingPkgInfo = info;
-    downloadFile(info.downloadUrl);
-}
-
-void AppManagerJob::downloadFile(const QString &url)
+void AppManagerJob::downloadPkgFile(int downloadId, const PkgInfo &info)
 {
     if (!m_isInitiallized) {
         init();
     }
 
-    QString realUrl = url;
-    // 获取文件大小
-    qint64 fileSize = getUrlFileSize(realUrl);
-    qInfo() << Q_FUNC_INFO << fileSize;
-    if (0 > fileSize) {
-        Q_EMIT pkgFileDownloadFailed(m_downloadingPkgInfo);
-        return;
-    }
-    qint64 endOffset = fileSize;
-
     // 创建下载路径
     QString fileName = QString(PKG_NAME_FORMAT_STR)
-            .arg(m_downloadingPkgInfo.pkgName)
-            .arg(m_downloadingPkgInfo.version)
-            .arg(m_downloadingPkgInfo.arch);
+            .arg(info.pkgName)
+            .arg(info.version)
+            .arg(info.arch);
+    const QString filePath = QString("%1/%2").arg(m_downloadDirPath).arg(fileName);
 
     QDir downloadDir(m_downloadDirPath);
     if (!downloadDir.exists()) {
         downloadDir.mkpath(m_downloadDirPath);
     }
 
-    m_downloadingFile = new QFile(QString("%1/%2")
-                                      .arg(m_downloadDirPath)
-                                      .arg(fileName));
-    if (!m_downloadingFile->open(QIODevice::OpenModeFlag::WriteOnly)) {
-        qDebug() << Q_FUNC_INFO << m_downloadingFile->fileName() << "open failed";
-        m_downloadingFile->deleteLater();
-        m_downloadingFile = nullptr;
+    // 本地已有同一安装包时直接复制，不再下载
+    // 校验本地文件需读取整个文件，在线程池中进行，不阻塞本线程中正在进行的下载
+    m_downloadingPkgInfoMap.insert(downloadId, info);
+    const QStringList dirPathList = {APT_ARCHIVES_DIR_PATH, m_downloadDirPath, m_pkgBuildDirPath};
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, downloadId, filePath] {
+        watcher->deleteLater();
+        startPkgFileDownload(downloadId, filePath, watcher->result());
+    });
+    watcher->setFuture(QtConcurrent::run(&PkgFileCache::reusePkgFile, info, dirPathList, filePath));
+}
+
+void AppManagerJob::startPkgFileDownload(int downloadId, const QString &filePath, const QString &cachedFilePath)
+{
+    // 查找期间已取消
+    if (!m_downloadingPkgInfoMap.contains(downloadId)) {
         return;
     }
 
-    qInfo() << Q_FUNC_INFO << realUrl;
-    QNetworkRequest request(realUrl);
-    QString range = QString("bytes=%0-%1").arg(0).arg(endOffset);
-    request.setRawHeader("Range", range.toUtf8());
+    const PkgInfo info = m_downloadingPkgInfoMap.value(downloadId);
+    if (!cachedFilePath.isEmpty()) {
+        qInfo() << Q_FUNC_INFO << downloadId << "reuse" << cachedFilePath;
+        m_downloadingPkgInfoMap.remove(downloadId);
+        const qint64 cachedFileSize = QFileInfo(filePath).size();
+        Q_EMIT pkgFileDownloadProgressChanged(downloadId, info, cachedFileSize, cachedFileSize);
+        Q_EMIT pkgFileDownloadFinished(downloadId, info);
+        return;
+    }
+
+    // 仓库索引中的大小作为预期大小，下载时以响应中的大小为准，不再预先请求
+    const qint64 fileSize = (0 < info.pkgSize) ? info.pkgSize : -1;
 
-    // https需要的配置（http不需要）
-    QSslConfiguration sslConf = request.sslConfiguration();
-    sslConf.setPeerVerifyMode(QSslSocket::VerifyNone);
-    request.setSslConfiguration(sslConf);
+    // 按仓库索引中的校验值校验，优先SHA256
+    QCryptographicHash::Algorithm checksumAlgorithm = QCryptographicHash::Sha256;
+    QString checksum = info.sha256;
+    if (checksum.isEmpty()) {
+        checksumAlgorithm = QCryptographicHash::Md5;
+        checksum = info.md5sum;
+    }
 
-    m_netReply = m_netManager->get(request);
-    connect(m_netReply, &QNetworkReply::readyRead, this, &AppManagerJob::onHttpReadyRead);
-    connect(m_netReply, &QNetworkReply::downloadProgress, this, &AppManagerJob::onDownloadProgressChanged);
-    connect(m_netReply, &QNetworkReply::finished, this, &AppManagerJob::onFileDownloadFinished);
+    qInfo() << Q_FUNC_INFO << downloadId << info.downloadUrl << fileSize << checksum;
+    // 加入下载队列，已有未完成的下载时续传
+    m_downloadManager->addDownload(downloadId, info.downloadUrl, filePath, fileSize, checksumAlgorithm, checksum);
 }
 
-void AppManagerJob::onHttpReadyRead()
+void AppManagerJob::cancelPkgFileDownload(int downloadId)
 {
-    if (m_downloadingFile) {
-        const QByteArray &ba = m_netReply->readAll();
-        m_downloadingFile->write(ba);
+    if (m_downloadManager && m_downloadManager->isDownloading(downloadId)) {
+        m_downloadManager->cancelDownload(downloadId);
+        return;
+    }
+
+    // 仍在查找本地安装包，查找完成后不再下载
+    if (m_downloadingPkgInfoMap.contains(downloadId)) {
+        const PkgInfo info = m_downloadingPkgInfoMap.take(downloadId);
+        Q_EMIT pkgFileDownloadCanceled(downloadId, info);
     }
 }
 
-void AppManagerJob::onDownloadProgressChanged(qint64 bytesRead, qint64 totalBytes)
+void AppManagerJob::onDownloadProgressChanged(int downloadId, qint64 bytesRead, qint64 totalBytes)
 {
-    Q_EMIT pkgFileDownloadProgressChanged(m_downloadingPkgInfo, bytesRead, totalBytes);
+    Q_EMIT pkgFileDownloadProgressChanged(downloadId, m_downloadingPkgInfoMap.value(downloadId), bytesRead, totalBytes);
 }
 
-void AppManagerJob::onFileDownloadFinished()
+void AppManagerJob::onFileDownloadFinished(int downloadId)
 {
-    m_netReply->deleteLater();
-    m_netReply = nullptr;
-
-    m_downloadingFile->flush();
-    m_downloadingFile->close();
-    sync();
-    m_downloadingFile->deleteLater();
-    m_downloadingFile = nullptr;
-
-    Q_EMIT pkgFileDownloadFinished(m_downloadingPkgInfo);
+    // 下载任务完成时已对文件落盘，不再全局sync
+    const PkgInfo info = m_downloadingPkgInfoMap.take(downloadId);
+    Q_EMIT pkgFileDownloadFinished(downloadId, info);
 }
 
-void AppManagerJob::startBuildPkgTask(const AppInfo &info, bool withDepends)
+void AppManagerJob::onFileDownloadFailed(int downloadId, const QString &err)
 {
-    bool successed = buildPkg(info.installedPkgInfo, withDepends);
-    Q_EMIT buildPkgTaskFinished(successed, info);
+    qWarning() << Q_FUNC_INFO << downloadId << err;
+    const PkgInfo info = m_downloadingPkgInfoMap.take(downloadId);
+
+    Q_EMIT pkgFileDownloadFailed(downloadId, info);
 }
 
-void AppManagerJob::startSearchTask(const QString &text)
+void AppManagerJob::onFileDownloadCanceled(int downloadId)
 {
-    if (text.isEmpty()) {
-        m_searchedAppInfoList = m_appInfosMap.values();
-        Q_EMIT searchTaskFinished();
-        return;
-    }
-
-    // 待匹配的字符串（不区分大小写）
-    const QString matchingText = text.toLower();
-    m_searchedAppInfoList.clear();
-    for (const AppInfo &appInfo : m_appInfosMap.values()) {
-        m_mutex.lock();
-        // 匹配包名称
-        // 不区分大小写
-        const QString pkgNameLowerStr = appInfo.pkgName.toLower();
-        if (pkgNameLowerStr.contains(matchingText)) {
-            m_searchedAppInfoList.append(appInfo);
-            m_mutex.unlock();
-            continue;
-        }
+    qInfo() << Q_FUNC_INFO << downloadId;
+    const PkgInfo info = m_downloadingPkgInfoMap.take(downloadId);
 
-        // 应用名称对应的无声调拼音
-        PinyinInfo pinYinInfo = AM::getPinYinInfoFromStr(appInfo.desktopInfo.appName);
-        if (pinYinInfo.noTonePinYin.contains(matchingText)) {
-            m_searchedAppInfoList.append(appInfo);
-            m_mutex.unlock();
-            continue;
-        }
-        // 应用名称拼音首字母缩写
-        if (pinYinInfo.simpliyiedPinYin.contains(matchingText)) {
-            m_searchedAppInfoList.append(appInfo);
-            m_mutex.unlock();
-            continue;
-        }
-        // 匹配应用名称
-        // 不区分大小写
-        const QString nameLowerStr = appInfo.desktopInfo.appName.toLower();
-        if (nameLowerStr.contains(matchingText)) {
-            m_searchedAppInfoList.append(appInfo);
-            m_mutex.unlock();
-            continue;
-        }
+    Q_EMIT pkgFileDownloadCanceled(downloadId, info);
+}
 
-        m_mutex.unlock();
-    }
-    Q_EMIT searchTaskFinished();
+void AppManagerJob::startBuildPkgTask(const AppInfo &info, bool withDepends)
+{
+    bool successed = buildPkg(info.installedPkgInfo, withDepends);
+    Q_EMIT buildPkgTaskFinished(successed, info);
 }
 
 void AppManagerJob::uninstallPkg(const QString &pkgName)
@@ -581,6 +574,8 @@ void AppManagerJob::onPkgUninstalled(const QString &pkgName)
     appInfo->isInstalled = false;
     appInfo->installedPkgInfo = {};
     appInfo->desktopInfo = {};
+    updateAppSearchKeys(*appInfo);
+    m_searchIndex.updateApp(*appInfo);
     m_mutex.unlock(); // 解锁
 
     PkgInfo pkgInfo;
@@ -761,6 +756,14 @@ bool AppManagerJob::getPkgInfoListFromFile(QList<PkgInfo> &pkgInfoList, const QS
                 pkgInfo.pkgSize = lineText.split(": ").last().toInt();
                 continue;
             }
+            if (lineText.startsWith("SHA256: ")) {
+                pkgInfo.sha256 = lineText.split(": ").last();
+                continue;
+            }
+            if (lineText.startsWith("MD5sum: ")) {
+                pkgInfo.md5sum = lineText.split(": ").last();
+                continue;
+            }
 
             if (lineText.startsWith("Homepage: ")) {
                 pkgInfo.homepage = lineText.split(": ").last();
@@ -786,7 +789,7 @@ bool AppManagerJob::getPkgInfoListFromFile(QList<PkgInfo> &pkgInfoList, const QS
             if (lineText.isEmpty()) {
                 pkgInfo.infosFilePath = pkgInfosFilePath;
                 pkgInfo.depositoryUrl = depositoryUrlStr;
-                pkgInfo.updatedTime = getPkgUpdatedTime(pkgInfo.pkgName, pkgInfo.arch);
+                loadPkgUpdatedTime(pkgInfo);
                 pkgInfoList.append(pkgInfo);
                 pkgInfo = {};
             }
@@ -866,6 +869,14 @@ bool AppManagerJob::getInstalledPkgInfo(PkgInfo &pkgInfo, const QString &pkgName
             pkgInfo.pkgSize = lineText.split(": ").last().toInt();
             continue;
         }
+        if (lineText.startsWith("SHA256: ")) {
+            pkgInfo.sha256 = lineText.split(": ").last();
+            continue;
+        }
+        if (lineText.startsWith("MD5sum: ")) {
+            pkgInfo.md5sum = lineText.split(": ").last();
+            continue;
+        }
 
         if (lineText.startsWith("Homepage: ")) {
             pkgInfo.homepage = lineText.split(": ").last();
@@ -890,7 +901,7 @@ bool AppManagerJob::getInstalledPkgInfo(PkgInfo &pkgInfo, const QString &pkgName
         // 检测到下一包信息
         if (lineText.isEmpty()) {
             pkgInfo.infosFilePath = localPkgInfosFilePath;
-            pkgInfo.updatedTime = getPkgUpdatedTime(pkgInfo.pkgName, pkgInfo.arch);
+            loadPkgUpdatedTime(pkgInfo);
             if (pkgName == pkgInfo.pkgName) {
                 if (pkgInfo.isInstalled) {
                     break;
@@ -915,8 +926,12 @@ void AppManagerJob::loadSrvAppInfosFromFile(QMap<QString, AppInfo> &appInfosMap,
     for (const PkgInfo &pkgInfo : pkgInfoList) {
         m_mutex.lock(); // appInfosMap为成员变量，加锁
         AppInfo *appInfo = &appInfosMap[pkgInfo.pkgName];
-        appInfo->pkgName = pkgInfo.pkgName;
+        if (appInfo->pkgName.isEmpty()) {
+            appInfo->pkgName = pkgInfo.pkgName;
+            updateAppSearchKeys(*appInfo);
+        }
         appInfo->pkgInfoList.append(pkgInfo);
+        m_searchIndex.updateAppAttributes(*appInfo);
         m_mutex.unlock(); // 解锁
     }
 }
@@ -949,6 +964,9 @@ void AppManagerJob::loadPkgInstalledAppInfo(const AM::PkgInfo &pkgInfo)
             break;
         }
     }
+    // 应用名称变化后，更新搜索关键字和索引
+    updateAppSearchKeys(*appInfo);
+    m_searchIndex.updateApp(*appInfo);
 
     m_mutex.unlock(); // 解锁
 }
@@ -1074,55 +1092,23 @@ DesktopInfo AppManagerJob::getDesktopInfo(const QString &desktop)
     return desktopInfo;
 }
 
-QString AppManagerJob::getPkgUpdatedTime(const QString &pkgName, const QString &arch)
+void AppManagerJob::loadPkgUpdatedTime(PkgInfo &pkgInfo)
 {
     // 判断文件名中是否有架构名
-    QString listFilePath = QString("/var/lib/dpkg/info/%1.list").arg(pkgName);
-    QString archContent = QFile::exists(listFilePath) ? "" : QString(":%1").arg(arch);
+    QString listFilePath = QString("/var/lib/dpkg/info/%1.list").arg(pkgInfo.pkgName);
+    QString archContent = QFile::exists(listFilePath) ? "" : QString(":%1").arg(pkgInfo.arch);
 
-    QFileInfo fInfo(QString("/var/lib/dpkg/info/%1%2.list").arg(pkgName).arg(archContent));
+    QFileInfo fInfo(QString("/var/lib/dpkg/info/%1%2.list").arg(pkgInfo.pkgName).arg(archContent));
     if (!fInfo.exists()) {
         qInfo() << Q_FUNC_INFO << fInfo.fileName() << "not exists!";
-        return "";
+        pkgInfo.updatedTime = "";
+        pkgInfo.updatedTimestamp = 0;
+        return;
     }
 
-    return fInfo.lastModified().toString(DATE_TIME_FORMAT_STR);
-}
-
-qint64 AppManagerJob::getUrlFileSize(QString &url, int tryTimes)
-{
-    qint64 size = -1;
-    while (tryTimes--) {
-        QNetworkAccessManager manager;
-        QEventLoop loop;
-        QNetworkRequest request;
-        request.setUrl(url);
-
-        QSslConfiguration sslConfig = request.sslConfiguration();
-        sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
-        request.setSslConfiguration(sslConfig);
-
-        QNetworkReply *reply = manager.head(request);
-        if (!reply) {
-            continue;
-        }
-        connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
-        loop.exec();
-
-        if (reply->error() != QNetworkReply::NoError) {
-            continue;
-        }
-
-        size = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
-        QVariant redirection = reply->attribute(QNetworkRequest::RedirectionTargetAttribute);
-        if (!redirection.isNull()) {
-            url = redirection.toString();
-            size = getUrlFileSize(url, tryTimes);
-        }
-        reply->deleteLater();
-        break;
-    }
-    return size;
+    const QDateTime lastModified = fInfo.lastModified();
+    pkgInfo.updatedTime = lastModified.toString(DATE_TIME_FORMAT_STR);
+    pkgInfo.updatedTimestamp = lastModified.toMSecsSinceEpoch();
 }
 
 bool AppManagerJob::buildPkg(const PkgInfo &pkgInfo, bool withDepends)
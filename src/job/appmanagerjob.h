@@ -2,10 +2,12 @@
 
 #include "../common/appmanagercommon.h"
 #include "../pkgmonitor/pkgmonitor.h"
+#include "../search/appsearchindex.h"
 
 #include <QObject>
 #include <QMap>
 #include <QMutex>
+#include <QAtomicInt>
 
 QT_BEGIN_NAMESPACE
 class QNetworkAccessManager;
@@ -14,6 +16,8 @@ class QFile;
 class QStandardItemModel;
 QT_END_NAMESPACE
 
+class PkgDownloadManager;
+
 #define OH_MY_DDE_PKG_NAME "top.yzzi.youjian"
 #define PROC_INFO_PLUGIN_PKG_NAME "com.github.ccc-proc-info-plugin"
 // 本地安装包路径
@@ -34,26 +38,25 @@ public:
     RunningStatus getRunningStatus();
 
     QMap<QString, AM::AppInfo> getAppInfosMap();
+    // 获取搜索索引快照
+    AppSearchIndex getSearchIndex();
 
-    QList<AM::AppInfo> getSearchedAppInfoList();
     QString getDownloadDirPath() const;
     QString getPkgBuildDirPath() const;
+    // 分配下载编号，可在其他线程中调用
+    int createDownloadId();
 
 public Q_SLOTS:
     void init();
     void reloadAppInfos();
     void downloadPkg(const QString &pkgName);
-    void downloadPkgFile(const PkgInfo &info);
-    void downloadFile(const QString &url);
-    void onHttpReadyRead();
-    void onDownloadProgressChanged(qint64, qint64);
-    void onFileDownloadFinished();
+    // 下载安装包文件，超过同时下载数时排队
+    void downloadPkgFile(int downloadId, const PkgInfo &info);
+    // 取消下载，已下载的部分保留以便续传
+    void cancelPkgFileDownload(int downloadId);
     // 开始构建安装包任务
     void startBuildPkgTask(const AM::AppInfo &info, bool withDepends);
 
-    // 开始搜索任务
-    void startSearchTask(const QString &text);
-
     void uninstallPkg(const QString &pkgName);
     void installOhMyDDE();
 
@@ -61,6 +64,11 @@ public Q_SLOTS:
     void holdPkgVersion(const QString &pkgName, bool hold);
 
 private Q_SLOTS:
+    // 下载状态变化
+    void onDownloadProgressChanged(int downloadId, qint64 bytesRead, qint64 totalBytes);
+    void onFileDownloadFinished(int downloadId);
+    void onFileDownloadFailed(int downloadId, const QString &err);
+    void onFileDownloadCanceled(int downloadId);
     // 包安装变动
     void onPkgInstalled(const QString &pkgName);
     void onPkgUpdated(const QString &pkgName);
@@ -70,12 +78,10 @@ Q_SIGNALS:
     void runningStatusChanged(RunningStatus status);
     void loadAppInfosFinished();
     void downloadPkgFinished(const QString &pkgName);
-    void pkgFileDownloadProgressChanged(const PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
-    void pkgFileDownloadFinished(const PkgInfo &info);
-    void pkgFileDownloadFailed(const PkgInfo &info);
-
-    // 搜索任务完成
-    void searchTaskFinished();
+    void pkgFileDownloadProgressChanged(int downloadId, const PkgInfo &info, qint64 bytesRead, qint64 totalBytes);
+    void pkgFileDownloadFinished(int downloadId, const PkgInfo &info);
+    void pkgFileDownloadFailed(int downloadId, const PkgInfo &info);
+    void pkgFileDownloadCanceled(int downloadId, const PkgInfo &info);
 
     void uninstallPkgFinished(const QString &pkgName);
     // 构建安装包任务完成
@@ -107,15 +113,16 @@ private:
     QStringList getAppInstalledFileList(const QString &pkgName, const QString &arch);
     QStringList getAppDesktopPathList(const QStringList &list, const QString &pkgName);
     AM::DesktopInfo getDesktopInfo(const QString &desktop);
-    QString getPkgUpdatedTime(const QString &pkgName, const QString &arch);
-
-    qint64 getUrlFileSize(QString &url, int tryTimes = 3);
+    // 获取包的更新时间（dpkg安装文件列表的修改时间）
+    void loadPkgUpdatedTime(AM::PkgInfo &pkgInfo);
 
     // 构建安装包任务
     bool buildPkg(const AM::PkgInfo &pkgInfo, bool withDepends = false);
     // 安全本地软件包
     bool installLocalPkg(const QString &path, QString &err);
     QStringList getPkgDepends(QStringList &findedPkgNameList, const QString &pkgName);
+    // 本地安装包查找完成后，找到时直接完成，否则加入下载队列
+    void startPkgFileDownload(int downloadId, const QString &filePath, const QString &cachedFilePath);
 
 private:
     QMutex m_mutex;
@@ -124,15 +131,16 @@ private:
     QString m_currentCpuArchStr;
     bool m_isOnlyLoadCurrentArchAppInfos;
     QMap<QString, AM::AppInfo> m_appInfosMap;
+    // 应用搜索索引，与m_appInfosMap同步更新
+    AppSearchIndex m_searchIndex;
 
     bool m_isInitiallized;
     QString m_downloadDirPath;
-    QFile *m_downloadingFile;
     QNetworkAccessManager *m_netManager;
-    QNetworkReply *m_netReply;
-    PkgInfo m_downloadingPkgInfo;
+    PkgDownloadManager *m_downloadManager;
+    QAtomicInt m_latestDownloadId;
+    QMap<int, PkgInfo> m_downloadingPkgInfoMap; // 下载编号 -> 包信息
 
-    QList<AM::AppInfo> m_searchedAppInfoList;
     // deb构建缓存目录
     QString m_pkgBuildCacheDirPath;
     // deb构建目录
@@ -0,0 +1,296 @@
+#include "appsearchjob.h"
+#include "appmanagerjob.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace AM;
+
+// 仓库包信息列表目录
+#define APT_LISTS_DIR_PATH "/var/lib/apt/lists"
+
+// 搜索结果项：匹配等级, 条目id
+typedef QPair<int, int> RankedId;
+
+// 在一个分片中校验候选项，索引为只读快照，无需加锁
+// 先比较过滤条件，再匹配搜索词
+static QVector<RankedId> matchSearchShard(const AppSearchIndex &searchIndex, const AppSearchIndex::FilterPlan &filterPlan,
+                                          const AppSearchIndex::Pattern &pattern,
+                                          const QVector<int> &candidateIdList, int begin, int end)
+{
+    QVector<RankedId> rankedIdList;
+    for (int i = begin; i < end; ++i) {
+        const int id = candidateIdList.at(i);
+        if (!searchIndex.isFilterMatched(id, filterPlan) || !searchIndex.isMatched(id, pattern)) {
+            continue;
+        }
+        rankedIdList.append({searchIndex.getMatchRank(id, pattern), id});
+    }
+    return rankedIdList;
+}
+
+AppSearchJob::AppSearchJob(AppManagerJob *appManagerJob, QObject *parent)
+    : QObject(parent)
+    , m_appManagerJob(appManagerJob)
+    , m_latestSearchId(0)
+    , m_lastIndexRevision(-1)
+    , m_descIndexWatcher(nullptr)
+    , m_isDescIndexReloadPending(false)
+    , m_aptListsWatcher(nullptr)
+    , m_descIndexReloadTimer(nullptr)
+{
+}
+
+AppSearchJob::~AppSearchJob()
+{
+}
+
+int AppSearchJob::createSearchId()
+{
+    return m_latestSearchId.fetchAndAddOrdered(1) + 1;
+}
+
+bool AppSearchJob::isSearchCancelled(int searchId) const
+{
+    return searchId != m_latestSearchId.loadAcquire();
+}
+
+void AppSearchJob::init()
+{
+    m_descIndexWatcher = new QFutureWatcher<QSharedPointer<AppDescIndex>>(this);
+    connect(m_descIndexWatcher, &QFutureWatcher<QSharedPointer<AppDescIndex>>::finished, this, &AppSearchJob::onDescIndexLoaded);
+
+    m_descIndexReloadTimer = new QTimer(this);
+    m_descIndexReloadTimer->setSingleShot(true);
+    m_descIndexReloadTimer->setInterval(DESC_INDEX_RELOAD_DELAY_MS);
+    connect(m_descIndexReloadTimer, &QTimer::timeout, this, &AppSearchJob::reloadDescIndex);
+
+    // 更新仓库后重建描述索引
+    m_aptListsWatcher = new QFileSystemWatcher(this);
+    m_aptListsWatcher->addPath(APT_LISTS_DIR_PATH);
+    connect(m_aptListsWatcher, &QFileSystemWatcher::directoryChanged, m_descIndexReloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+
+    reloadDescIndex();
+}
+
+QList<AppInfo> AppSearchJob::getSearchedAppInfoList()
+{
+    QList<AppInfo> appInfoList;
+    m_mutex.lock();
+    appInfoList = m_searchedAppInfoList;
+    m_mutex.unlock();
+
+    return appInfoList;
+}
+
+void AppSearchJob::startSearchTask(int searchId, const QString &text)
+{
+    // 已有更新的搜索，直接丢弃
+    if (isSearchCancelled(searchId)) {
+        return;
+    }
+
+    m_mutex.lock();
+    m_searchedAppInfoList.clear();
+    m_mutex.unlock();
+
+    // 获取索引和应用信息快照，搜索过程中不再加锁
+    const AppSearchIndex searchIndex = m_appManagerJob->getSearchIndex();
+    const QMap<QString, AppInfo> appInfosMap = m_appManagerJob->getAppInfosMap();
+
+    // 解析查询语句，过滤条件编译为过滤计划，与搜索词在同一次遍历中匹配
+    const AppQuery query(text);
+    const AppSearchIndex::FilterPlan filterPlan = searchIndex.compileFilterPlan(query);
+    const QString freeText = query.getFreeText();
+
+    // 待匹配的字符串（不区分大小写）
+    const QString matchingText = freeText.toLower();
+    const AppSearchIndex::Pattern pattern = AppSearchIndex::createPattern(matchingText);
+
+    // 本次搜索词包含上次搜索词，且索引未变化时，只需在上次结果中查找
+    // 过滤条件变化时范围不一定缩小，不使用上次结果
+    QVector<int> candidateIdList;
+    if (filterPlan.isEmpty
+            && !m_lastMatchingText.isEmpty()
+            && matchingText.contains(m_lastMatchingText)
+            && searchIndex.getRevision() == m_lastIndexRevision) {
+        candidateIdList = m_lastMatchedIdList;
+    } else {
+        candidateIdList = searchIndex.getCandidateIdList(pattern);
+    }
+
+    // 候选项分片后在线程池中同时校验
+    const int shardCount = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int batchCandidateCount = SEARCH_SHARD_CANDIDATE_COUNT * shardCount;
+
+    QVector<int> matchedIdList;
+    for (int begin = 0; begin < candidateIdList.size(); begin += batchCandidateCount) {
+        if (isSearchCancelled(searchId)) {
+            qInfo() << Q_FUNC_INFO << text << "cancelled";
+            return;
+        }
+
+        const int batchEnd = qMin(begin + batchCandidateCount, candidateIdList.size());
+        QList<QFuture<QVector<RankedId>>> shardFutureList;
+        for (int shardBegin = begin; shardBegin < batchEnd; shardBegin += SEARCH_SHARD_CANDIDATE_COUNT) {
+            const int shardEnd = qMin(shardBegin + SEARCH_SHARD_CANDIDATE_COUNT, batchEnd);
+            shardFutureList.append(QtConcurrent::run(matchSearchShard, searchIndex, filterPlan, pattern,
+                                                     candidateIdList, shardBegin, shardEnd));
+        }
+
+        // 按分片顺序合并，保证结果顺序稳定
+        QVector<RankedId> rankedIdList;
+        for (QFuture<QVector<RankedId>> &shardFuture : shardFutureList) {
+            rankedIdList.append(shardFuture.result());
+        }
+        if (rankedIdList.isEmpty()) {
+            continue;
+        }
+        // 本批次按匹配等级排序
+        std::stable_sort(rankedIdList.begin(), rankedIdList.end(), [](const RankedId &a, const RankedId &b) {
+            return a.first < b.first;
+        });
+
+        QList<AppInfo> batchAppInfoList;
+        for (const RankedId &rankedId : rankedIdList) {
+            matchedIdList.append(rankedId.second);
+            batchAppInfoList.append(appInfosMap.value(searchIndex.getPkgName(rankedId.second)));
+        }
+
+        m_mutex.lock();
+        m_searchedAppInfoList.append(batchAppInfoList);
+        m_mutex.unlock();
+        Q_EMIT searchResultsFound(searchId, batchAppInfoList);
+    }
+
+    // 记录本次结果，供下次缩小范围
+    std::sort(matchedIdList.begin(), matchedIdList.end());
+    m_lastMatchingText = filterPlan.isEmpty ? matchingText : QString();
+    m_lastMatchedIdList = matchedIdList;
+    m_lastIndexRevision = searchIndex.getRevision();
+
+    QSet<QString> matchedPkgNameSet;
+    for (const int id : matchedIdList) {
+        matchedPkgNameSet.insert(searchIndex.getPkgName(id));
+    }
+
+    // 容错匹配的结果排在精确匹配的结果之后
+    if (!isSearchCancelled(searchId)) {
+        QList<AppInfo> fuzzyAppInfoList;
+        const QVector<FuzzyMatchedId> fuzzyMatchedIdList = searchIndex.getFuzzyMatchedIdList(pattern, matchedIdList);
+        for (const FuzzyMatchedId &fuzzyMatchedId : fuzzyMatchedIdList) {
+            if (FUZZY_SEARCH_MAX_COUNT <= fuzzyAppInfoList.size()) {
+                break;
+            }
+            if (!searchIndex.isFilterMatched(fuzzyMatchedId.id, filterPlan)) {
+                continue;
+            }
+            const QString pkgName = searchIndex.getPkgName(fuzzyMatchedId.id);
+            matchedPkgNameSet.insert(pkgName);
+            fuzzyAppInfoList.append(appInfosMap.value(pkgName));
+        }
+
+        if (!fuzzyAppInfoList.isEmpty()) {
+            m_mutex.lock();
+            m_searchedAppInfoList.append(fuzzyAppInfoList);
+            m_mutex.unlock();
+            Q_EMIT searchResultsFound(searchId, fuzzyAppInfoList);
+        }
+    }
+
+    // 描述匹配的结果排在名称匹配的结果之后
+    if (!m_descIndex.isNull() && !isSearchCancelled(searchId)) {
+        QList<AppInfo> descAppInfoList;
+        // 过滤条件在取前若干个结果之前应用
+        const QList<DescSearchResult> descResultList = m_descIndex->search(freeText, DESC_SEARCH_MAX_COUNT, [&](const QString &pkgName) {
+            if (matchedPkgNameSet.contains(pkgName) || !appInfosMap.contains(pkgName)) {
+                return false;
+            }
+            const int id = searchIndex.getId(pkgName);
+            return -1 != id && searchIndex.isFilterMatched(id, filterPlan);
+        });
+        for (const DescSearchResult &descResult : descResultList) {
+            descAppInfoList.append(appInfosMap.value(descResult.first));
+        }
+
+        if (!descAppInfoList.isEmpty()) {
+            m_mutex.lock();
+            m_searchedAppInfoList.append(descAppInfoList);
+            m_mutex.unlock();
+            Q_EMIT searchResultsFound(searchId, descAppInfoList);
+        }
+    }
+
+    Q_EMIT searchTaskFinished(searchId);
+}
+
+void AppSearchJob::reloadDescIndex()
+{
+    if (m_descIndexWatcher->isRunning()) {
+        m_isDescIndexReloadPending = true;
+        return;
+    }
+
+    const QStringList listFilePathList = getAptListFilePathList();
+    // 包信息列表未变化
+    if (!m_descIndex.isNull() && m_descIndex->getSignature() == AppDescIndex::getListFilesSignature(listFilePathList)) {
+        return;
+    }
+
+    const QString cacheDirPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cacheDirPath);
+    const QString indexFilePath = QString("%1/desc-index.dat").arg(cacheDirPath);
+    m_descIndexWatcher->setFuture(QtConcurrent::run(loadOrBuildDescIndex, listFilePathList, indexFilePath));
+}
+
+void AppSearchJob::onDescIndexLoaded()
+{
+    const QSharedPointer<AppDescIndex> descIndex = m_descIndexWatcher->result();
+    if (!descIndex.isNull() && !descIndex->isEmpty()) {
+        m_descIndex = descIndex;
+    }
+
+    if (m_isDescIndexReloadPending) {
+        m_isDescIndexReloadPending = false;
+        reloadDescIndex();
+    }
+}
+
+QStringList AppSearchJob::getAptListFilePathList()
+{
+    QStringList listFilePathList;
+    QDir aptPkgInfoListDir(APT_LISTS_DIR_PATH);
+    const QStringList fileNameList = aptPkgInfoListDir.entryList(QDir::Filter::Files | QDir::Filter::NoDot | QDir::Filter::NoDotDot);
+    for (const QString &fileName : fileNameList) {
+        // 包信息列表和描述翻译文件
+        if (fileName.endsWith("_Packages") || fileName.contains("_i18n_Translation-")) {
+            listFilePathList.append(QString("%1/%2").arg(aptPkgInfoListDir.path()).arg(fileName));
+        }
+    }
+
+    return listFilePathList;
+}
+
+QSharedPointer<AppDescIndex> AppSearchJob::loadOrBuildDescIndex(const QStringList &listFilePathList, const QString &indexFilePath)
+{
+    QSharedPointer<AppDescIndex> descIndex(new AppDescIndex);
+    if (descIndex->loadFromFile(indexFilePath)
+            && descIndex->getSignature() == AppDescIndex::getListFilesSignature(listFilePathList)) {
+        qInfo() << Q_FUNC_INFO << "loaded from" << indexFilePath;
+        return descIndex;
+    }
+
+    descIndex->buildFromListFiles(listFilePathList);
+    if (!descIndex->saveToFile(indexFilePath)) {
+        qWarning() << Q_FUNC_INFO << "save to" << indexFilePath << "failed";
+    }
+    return descIndex;
+}
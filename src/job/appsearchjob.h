@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../common/appmanagercommon.h"
+#include "../search/appdescindex.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+class QFileSystemWatcher;
+class QTimer;
+class AppManagerJob;
+
+// 每个分片校验的候选项个数，每批次同时校验线程池线程数个分片
+#define SEARCH_SHARD_CANDIDATE_COUNT 2048
+// 模糊搜索结果的最大个数
+#define FUZZY_SEARCH_MAX_COUNT 200
+// 描述搜索结果的最大个数
+#define DESC_SEARCH_MAX_COUNT 200
+// 包信息列表目录变化后，延迟重建描述索引的时间（毫秒），避免更新仓库时频繁重建
+#define DESC_INDEX_RELOAD_DELAY_MS 3000
+
+// 搜索任务，运行在独立线程中，不受重载和构建任务阻塞
+class AppSearchJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppSearchJob(AppManagerJob *appManagerJob, QObject *parent = nullptr);
+    virtual ~AppSearchJob() override;
+
+    // 创建新的搜索id，同时取消正在进行的搜索（可在任意线程调用）
+    int createSearchId();
+    // 搜索是否已被新的搜索取消（可在任意线程调用）
+    bool isSearchCancelled(int searchId) const;
+
+    QList<AM::AppInfo> getSearchedAppInfoList();
+
+public Q_SLOTS:
+    void init();
+    // 开始搜索任务
+    void startSearchTask(int searchId, const QString &text);
+
+Q_SIGNALS:
+    // 找到一批搜索结果（批次内已按匹配等级排序）
+    void searchResultsFound(int searchId, const QList<AM::AppInfo> &appInfoList);
+    // 搜索任务完成
+    void searchTaskFinished(int searchId);
+
+private Q_SLOTS:
+    // 重新加载描述索引，包信息列表未变化时直接使用磁盘中的索引
+    void reloadDescIndex();
+    void onDescIndexLoaded();
+
+private:
+    // 获取仓库包信息列表文件路径
+    static QStringList getAptListFilePathList();
+    // 加载或构建描述索引（在线程池中运行）
+    static QSharedPointer<AppDescIndex> loadOrBuildDescIndex(const QStringList &listFilePathList, const QString &indexFilePath);
+
+private:
+    AppManagerJob *m_appManagerJob;
+    QAtomicInt m_latestSearchId;
+
+    QMutex m_mutex;
+    QList<AM::AppInfo> m_searchedAppInfoList;
+
+    // 上次完成的搜索，用于在其结果中继续缩小范围
+    QString m_lastMatchingText;
+    QVector<int> m_lastMatchedIdList; // 有序
+    int m_lastIndexRevision;
+
+    // 描述索引，只在搜索线程中访问
+    QSharedPointer<const AppDescIndex> m_descIndex;
+    QFutureWatcher<QSharedPointer<AppDescIndex>> *m_descIndexWatcher;
+    bool m_isDescIndexReloadPending; // 加载过程中又有变化，加载完成后需再次加载
+    QFileSystemWatcher *m_aptListsWatcher;
+    QTimer *m_descIndexReloadTimer;
+};
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "stallmonitor/stallmonitor.h"
 
 #include <DApplication>
 #include <DWidgetUtil>
@@ -29,6 +30,14 @@ int main(int argc, char *argv[])
         exit(0);
     }
 
+    // 界面线程卡顿监测，设置了环境变量时开启，退出时输出统计报告
+    if (StallMonitor::isEnabledByEnv()) {
+        StallMonitor::instance()->start();
+    }
+    QObject::connect(&a, &DApplication::aboutToQuit, &a, [] {
+        StallMonitor::instance()->stop();
+    });
+
     // 保存窗口主题设置
     DApplicationSettings settings;
 
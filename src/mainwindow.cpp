@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "stallmonitor/stallmonitor.h"
 
 #include <DTitlebar>
 #include <DFrame>
@@ -51,6 +52,16 @@ MainWindow::MainWindow(QWidget *parent)
     openProInfoWindowAction->setText("打开进程信息窗口");
     m_mainMenu->addAction(openProInfoWindowAction);
 
+    QAction *enableStallMonitorAction = new QAction(this);
+    enableStallMonitorAction->setText("开启界面卡顿监测");
+    enableStallMonitorAction->setCheckable(true);
+    enableStallMonitorAction->setChecked(StallMonitor::instance()->isRunning());
+    m_mainMenu->addAction(enableStallMonitorAction);
+
+    QAction *showStallReportAction = new QAction(this);
+    showStallReportAction->setText("界面卡顿统计");
+    m_mainMenu->addAction(showStallReportAction);
+
     m_centralWidgetBlurBg = new DBlurEffectWidget(this);
     m_centralWidgetBlurBg->setBlendMode(DBlurEffectWidget::BlendMode::BehindWindowBlend);
     m_centralWidgetBlurBg->setMaskAlpha(100);
@@ -157,6 +168,34 @@ MainWindow::MainWindow(QWidget *parent)
         }
     });
 
+    // 监测会定时唤醒，只在需要时开启
+    connect(enableStallMonitorAction, &QAction::toggled, this, [](bool checked) {
+        if (checked) {
+            StallMonitor::instance()->start();
+        } else {
+            StallMonitor::instance()->stop();
+        }
+    });
+
+    connect(showStallReportAction, &QAction::triggered, this, [this](bool checked) {
+        Q_UNUSED(checked);
+        QTextEdit *edit = new QTextEdit(this);
+        edit->setPlainText(StallMonitor::instance()->getReport());
+        edit->setReadOnly(true);
+        edit->setLineWrapMode(QTextEdit::LineWrapMode::NoWrap);
+        QPalette pa = edit->palette();
+        pa.setColor(QPalette::ColorRole::Base, Qt::transparent);
+        edit->setPalette(pa);
+
+        DDialog *dlg = new DDialog(this);
+        dlg->setOnButtonClickedClose(true);
+        dlg->setTitle("界面卡顿统计");
+        dlg->setMinimumWidth(800);
+        dlg->addContent(edit);
+
+        dlg->exec();
+        dlg->deleteLater();
+    });
 
     // 安装完成时
     connect(m_appManagerModel, &AppManagerModel::installOhMyDDEFinished, this, &MainWindow::onPkgInstallFinished);
@@ -164,7 +203,8 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::openSparkStoreNeedBeInstallDlg);
 
     // 下载失败
-    connect(m_appManagerModel, &AppManagerModel::pkgFileDownloadFailed, this, [this](const PkgInfo &info) {
+    connect(m_appManagerModel, &AppManagerModel::pkgFileDownloadFailed, this, [this](int downloadId, const PkgInfo &info) {
+        Q_UNUSED(downloadId);
         qInfo() << Q_FUNC_INFO << info.downloadUrl << "download failed!";
         DDialog *dlg = new DDialog(this);
         QString tip = QString("下载失败，请尝试在终端使用apt download %1命令下载").arg(info.pkgName);
@@ -0,0 +1,347 @@
+#include "appdescindex.h"
+#include "../common/appmanagercommon.h"
+#include "../common/pinyintable.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+using namespace AM;
+
+// 索引文件格式标识及版本，格式变化时需修改版本号
+#define DESC_INDEX_FILE_MAGIC 0x43434449
+#define DESC_INDEX_FILE_VERSION 2
+
+// BM25参数
+#define BM25_K1 1.2
+#define BM25_B 0.75
+
+// 英文单词最短长度
+#define MIN_WORD_LENGTH 2
+
+// 英文停用词
+static const QSet<QString> StopWordSet = {
+    "an", "and", "are", "as", "at", "be", "by", "for", "from", "in", "is", "it",
+    "of", "on", "or", "that", "the", "this", "to", "with"
+};
+
+// 获取汉字的无声调拼音
+static inline const QString &getNoTonePinYin(const QChar &character)
+{
+    return PinyinTable::instance()->getNoTonePinYin(character);
+}
+
+static void appendWordToken(QStringList &tokenList, QString &word)
+{
+    if (MIN_WORD_LENGTH <= word.size() && !StopWordSet.contains(word)) {
+        tokenList.append(word);
+    }
+    word.clear();
+}
+
+// 连续的汉字按二元组分词，同时添加对应的无声调拼音二元组，单个汉字单独成词
+static void appendChineseTokens(QStringList &tokenList, QString &chineseRun)
+{
+    if (1 == chineseRun.size()) {
+        tokenList.append(chineseRun);
+        tokenList.append(getNoTonePinYin(chineseRun.at(0)));
+    }
+    for (int i = 0; i + 1 < chineseRun.size(); ++i) {
+        tokenList.append(chineseRun.mid(i, 2));
+        tokenList.append(getNoTonePinYin(chineseRun.at(i)) + getNoTonePinYin(chineseRun.at(i + 1)));
+    }
+    chineseRun.clear();
+}
+
+AppDescIndex::AppDescIndex()
+    : m_totalDocLength(0)
+{
+}
+
+bool AppDescIndex::isEmpty() const
+{
+    return m_docPkgNameList.isEmpty();
+}
+
+QString AppDescIndex::getSignature() const
+{
+    return m_signature;
+}
+
+QString AppDescIndex::getListFilesSignature(const QStringList &listFilePathList)
+{
+    QStringList sortedPathList = listFilePathList;
+    sortedPathList.sort();
+
+    QStringList partList;
+    for (const QString &filePath : sortedPathList) {
+        const QFileInfo fileInfo(filePath);
+        partList.append(QString("%1:%2:%3").arg(filePath)
+                        .arg(fileInfo.size())
+                        .arg(fileInfo.lastModified().toMSecsSinceEpoch()));
+    }
+    return partList.join(";");
+}
+
+void AppDescIndex::buildFromListFiles(const QStringList &listFilePathList)
+{
+    m_signature = getListFilesSignature(listFilePathList);
+    m_docPkgNameList.clear();
+    m_docLengthList.clear();
+    m_totalDocLength = 0;
+    m_postingsMap.clear();
+
+    // 同一包可能出现在多个仓库、架构和翻译文件中，不同的描述合并为一个文档，相同的只保留一次
+    QStringList pkgNameList;
+    QHash<QString, QStringList> descriptionListMap;
+    for (const QString &filePath : listFilePathList) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << Q_FUNC_INFO << "open" << filePath << "failed";
+            continue;
+        }
+
+        QString pkgName;
+        QString description;
+        bool isReadingDescription = false;
+        while (true) {
+            const QByteArray line = file.readLine();
+            const bool isEnd = line.isEmpty();
+            const QByteArray trimmedLine = line.trimmed();
+            // 空行为段落结束
+            if (isEnd || trimmedLine.isEmpty()) {
+                if (!pkgName.isEmpty() && !description.isEmpty()) {
+                    QStringList &descriptionList = descriptionListMap[pkgName];
+                    if (descriptionList.isEmpty()) {
+                        pkgNameList.append(pkgName);
+                    }
+                    if (!descriptionList.contains(description)) {
+                        descriptionList.append(description);
+                    }
+                }
+                pkgName.clear();
+                description.clear();
+                isReadingDescription = false;
+                if (isEnd) {
+                    break;
+                }
+                continue;
+            }
+
+            // 以空白开头的行为上一字段的续行
+            if (' ' == line.at(0) || '\t' == line.at(0)) {
+                if (isReadingDescription && "." != trimmedLine) {
+                    description.append(' ');
+                    description.append(QString::fromUtf8(trimmedLine));
+                }
+                continue;
+            }
+
+            isReadingDescription = false;
+            if (line.startsWith("Package:")) {
+                pkgName = QString::fromUtf8(line.mid(int(strlen("Package:"))).trimmed());
+            } else if (line.startsWith("Description") && !line.startsWith("Description-md5:")) {
+                // 包信息列表中为Description，翻译文件中为Description-语言
+                const int colonIndex = line.indexOf(':');
+                if (-1 != colonIndex) {
+                    description = QString::fromUtf8(line.mid(colonIndex + 1).trimmed());
+                    isReadingDescription = true;
+                }
+            }
+        }
+        file.close();
+    }
+
+    for (const QString &pkgName : pkgNameList) {
+        addDocument(pkgName, descriptionListMap.value(pkgName).join(' '));
+    }
+
+    qInfo() << Q_FUNC_INFO << "docs:" << m_docPkgNameList.size() << "terms:" << m_postingsMap.size();
+}
+
+bool AppDescIndex::saveToFile(const QString &filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "open" << filePath << "failed";
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint32(DESC_INDEX_FILE_MAGIC) << quint32(DESC_INDEX_FILE_VERSION);
+    stream << m_signature << m_docPkgNameList << m_docLengthList << m_totalDocLength;
+
+    stream << quint32(m_postingsMap.size());
+    for (QHash<QString, QVector<Posting>>::const_iterator cIter = m_postingsMap.cbegin();
+            cIter != m_postingsMap.cend(); ++cIter) {
+        stream << cIter.key() << quint32(cIter.value().size());
+        for (const Posting &posting : cIter.value()) {
+            stream << posting.docId << posting.termFreq;
+        }
+    }
+
+    return file.commit();
+}
+
+bool AppDescIndex::loadFromFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (DESC_INDEX_FILE_MAGIC != magic || DESC_INDEX_FILE_VERSION != version) {
+        qWarning() << Q_FUNC_INFO << filePath << "format mismatched";
+        return false;
+    }
+
+    AppDescIndex index;
+    stream >> index.m_signature >> index.m_docPkgNameList >> index.m_docLengthList >> index.m_totalDocLength;
+
+    quint32 termCount = 0;
+    stream >> termCount;
+    index.m_postingsMap.reserve(int(termCount));
+    for (quint32 i = 0; i < termCount && QDataStream::Ok == stream.status(); ++i) {
+        QString term;
+        quint32 postingCount = 0;
+        stream >> term >> postingCount;
+        if (postingCount > quint32(index.m_docPkgNameList.size())) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        QVector<Posting> &postings = index.m_postingsMap[term];
+        postings.resize(int(postingCount));
+        for (Posting &posting : postings) {
+            stream >> posting.docId >> posting.termFreq;
+            if (0 > posting.docId || posting.docId >= index.m_docPkgNameList.size()) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+        }
+    }
+
+    if (QDataStream::Ok != stream.status()
+            || index.m_docPkgNameList.size() != index.m_docLengthList.size()) {
+        qWarning() << Q_FUNC_INFO << filePath << "corrupted";
+        return false;
+    }
+
+    *this = index;
+    return true;
+}
+
+QList<DescSearchResult> AppDescIndex::search(const QString &text, int maxCount,
+                                             const std::function<bool(const QString &)> &isAccepted) const
+{
+    QList<DescSearchResult> resultList;
+    if (isEmpty() || 0 >= maxCount) {
+        return resultList;
+    }
+
+    QStringList queryTermList = tokenize(text);
+    queryTermList.removeDuplicates();
+
+    const int docCount = m_docPkgNameList.size();
+    const double avgDocLength = double(m_totalDocLength) / docCount;
+    QVector<double> scoreList(docCount, 0);
+    QVector<int> touchedDocIdList;
+    for (const QString &term : queryTermList) {
+        QHash<QString, QVector<Posting>>::const_iterator cIter = m_postingsMap.constFind(term);
+        if (m_postingsMap.cend() == cIter) {
+            continue;
+        }
+
+        const QVector<Posting> &postings = cIter.value();
+        const double docFreq = postings.size();
+        const double idf = std::log(1 + (docCount - docFreq + 0.5) / (docFreq + 0.5));
+        for (const Posting &posting : postings) {
+            const double termFreq = posting.termFreq;
+            const double docLength = m_docLengthList.at(posting.docId);
+            const double norm = BM25_K1 * (1 - BM25_B + BM25_B * docLength / avgDocLength);
+            if (0 == scoreList.at(posting.docId)) {
+                touchedDocIdList.append(posting.docId);
+            }
+            scoreList[posting.docId] += idf * termFreq * (BM25_K1 + 1) / (termFreq + norm);
+        }
+    }
+
+    // 先排除不需要的结果，再取前maxCount个，避免过滤后结果不足
+    if (isAccepted) {
+        touchedDocIdList.erase(std::remove_if(touchedDocIdList.begin(), touchedDocIdList.end(), [&](int docId) {
+            return !isAccepted(m_docPkgNameList.at(docId));
+        }), touchedDocIdList.end());
+    }
+
+    // 只对前maxCount个结果排序
+    const int resultCount = qMin(maxCount, touchedDocIdList.size());
+    std::partial_sort(touchedDocIdList.begin(), touchedDocIdList.begin() + resultCount, touchedDocIdList.end(),
+                      [&scoreList](int a, int b) {
+        return scoreList.at(a) > scoreList.at(b);
+    });
+    for (int i = 0; i < resultCount; ++i) {
+        const int docId = touchedDocIdList.at(i);
+        resultList.append({m_docPkgNameList.at(docId), scoreList.at(docId)});
+    }
+
+    return resultList;
+}
+
+QStringList AppDescIndex::tokenize(const QString &text)
+{
+    QStringList tokenList;
+    QString word;
+    QString chineseRun;
+    for (const QChar &character : text) {
+        if (isChineseChar(character)) {
+            appendWordToken(tokenList, word);
+            chineseRun.append(character);
+        } else if (character.isLetterOrNumber()) {
+            appendChineseTokens(tokenList, chineseRun);
+            word.append(character.toLower());
+        } else {
+            appendWordToken(tokenList, word);
+            appendChineseTokens(tokenList, chineseRun);
+        }
+    }
+    appendWordToken(tokenList, word);
+    appendChineseTokens(tokenList, chineseRun);
+
+    return tokenList;
+}
+
+void AppDescIndex::addDocument(const QString &pkgName, const QString &description)
+{
+    const QStringList tokenList = tokenize(description);
+    if (tokenList.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, int> termFreqMap;
+    for (const QString &token : tokenList) {
+        ++termFreqMap[token];
+    }
+
+    // 文档id递增，倒排列表保持有序
+    const qint32 docId = m_docPkgNameList.size();
+    m_docPkgNameList.append(pkgName);
+    m_docLengthList.append(quint32(tokenList.size()));
+    m_totalDocLength += quint64(tokenList.size());
+    for (QHash<QString, int>::const_iterator cIter = termFreqMap.cbegin(); cIter != termFreqMap.cend(); ++cIter) {
+        m_postingsMap[cIter.key()].append({docId, quint16(qMin(cIter.value(), int(USHRT_MAX)))});
+    }
+}
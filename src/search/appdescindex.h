@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+// 描述搜索结果：包名, BM25得分
+typedef QPair<QString, double> DescSearchResult;
+
+// 应用描述全文索引
+// 对仓库包信息列表和翻译文件中的概要和详细描述建立倒排索引，按BM25排序，
+// 英文按单词分词，中文按二元组和无声调拼音二元组分词
+class AppDescIndex
+{
+public:
+    AppDescIndex();
+
+    bool isEmpty() const;
+    // 索引对应的包信息列表文件签名
+    QString getSignature() const;
+
+    // 根据包信息列表文件路径、大小和修改时间生成签名，文件变化后签名随之变化
+    static QString getListFilesSignature(const QStringList &listFilePathList);
+    // 从包信息列表文件和翻译文件构建索引
+    void buildFromListFiles(const QStringList &listFilePathList);
+    bool saveToFile(const QString &filePath) const;
+    bool loadFromFile(const QString &filePath);
+
+    // 搜索，返回按得分降序排列的结果，isAccepted不为空时只返回其接受的包
+    QList<DescSearchResult> search(const QString &text, int maxCount,
+                                   const std::function<bool(const QString &)> &isAccepted = nullptr) const;
+
+    // 分词
+    static QStringList tokenize(const QString &text);
+
+private:
+    // 倒排列表项
+    struct Posting {
+        qint32 docId;
+        quint16 termFreq; // 词频
+    };
+
+    void addDocument(const QString &pkgName, const QString &description);
+
+private:
+    QString m_signature;
+    QStringList m_docPkgNameList; // 文档id -> 包名
+    QVector<quint32> m_docLengthList; // 文档id -> 词数
+    quint64 m_totalDocLength;
+    QHash<QString, QVector<Posting>> m_postingsMap; // 词 -> 倒排列表
+};
@@ -0,0 +1,169 @@
+#include "appquery.h"
+#include "../common/appmanagercommon.h"
+
+#include <QRegularExpression>
+
+#include <limits>
+
+// 过滤条件格式：键 运算符 值
+static const QRegularExpression FilterTermRegular("^([a-z]+)(:|>=|<=|>|<|=)(.*)$");
+// 容量格式：数字 [单位]
+static const QRegularExpression SizeValueRegular("^(\\d+(?:\\.\\d+)?)([kmgt]?)b?$");
+
+AppQuery::SizeRange::SizeRange()
+    : min(0)
+    , max(std::numeric_limits<qint64>::max())
+{
+}
+
+bool AppQuery::SizeRange::isLimited() const
+{
+    return 0 < min || std::numeric_limits<qint64>::max() > max;
+}
+
+AppQuery::AppQuery(const QString &text)
+    : m_hasFilters(false)
+    , m_installedCondition(Any)
+    , m_heldCondition(Any)
+    , m_guiCondition(Any)
+{
+    QStringList freeTermList;
+    const QStringList termList = text.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+    for (const QString &term : termList) {
+        if (parseTerm(term)) {
+            m_hasFilters = true;
+        } else {
+            freeTermList.append(term);
+        }
+    }
+    m_freeText = m_hasFilters ? freeTermList.join(" ") : text;
+}
+
+bool AppQuery::hasFilters() const
+{
+    return m_hasFilters;
+}
+
+QString AppQuery::getFreeText() const
+{
+    return m_freeText;
+}
+
+AppQuery::BoolCondition AppQuery::getInstalledCondition() const
+{
+    return m_installedCondition;
+}
+
+AppQuery::BoolCondition AppQuery::getHeldCondition() const
+{
+    return m_heldCondition;
+}
+
+AppQuery::BoolCondition AppQuery::getGuiCondition() const
+{
+    return m_guiCondition;
+}
+
+QStringList AppQuery::getArchList() const
+{
+    return m_archList;
+}
+
+QStringList AppQuery::getRepoList() const
+{
+    return m_repoList;
+}
+
+AppQuery::SizeRange AppQuery::getInstalledSizeRange() const
+{
+    return m_installedSizeRange;
+}
+
+AppQuery::SizeRange AppQuery::getPkgSizeRange() const
+{
+    return m_pkgSizeRange;
+}
+
+bool AppQuery::parseTerm(const QString &term)
+{
+    const QRegularExpressionMatch match = FilterTermRegular.match(term.toLower());
+    if (!match.hasMatch()) {
+        return false;
+    }
+
+    const QString key = match.captured(1);
+    const QString op = match.captured(2);
+    const QString value = match.captured(3);
+    if ("installed" == key && ":" == op) {
+        return parseBoolCondition(value, &m_installedCondition);
+    } else if ("held" == key && ":" == op) {
+        return parseBoolCondition(value, &m_heldCondition);
+    } else if ("gui" == key && ":" == op) {
+        return parseBoolCondition(value, &m_guiCondition);
+    } else if ("arch" == key && ":" == op && !value.isEmpty()) {
+        m_archList.append(value.split(",", QString::SkipEmptyParts));
+        return true;
+    } else if ("repo" == key && ":" == op && !value.isEmpty()) {
+        m_repoList.append(value.split(",", QString::SkipEmptyParts));
+        return true;
+    } else if ("size" == key) {
+        return parseSizeCondition(op, value, &m_installedSizeRange);
+    } else if ("pkgsize" == key) {
+        return parseSizeCondition(op, value, &m_pkgSizeRange);
+    }
+
+    return false;
+}
+
+bool AppQuery::parseBoolCondition(const QString &value, BoolCondition *condition)
+{
+    if (value.isEmpty() || "yes" == value || "true" == value || "1" == value) {
+        *condition = Yes;
+        return true;
+    }
+    if ("no" == value || "false" == value || "0" == value) {
+        *condition = No;
+        return true;
+    }
+    return false;
+}
+
+bool AppQuery::parseSizeCondition(const QString &op, const QString &value, SizeRange *range)
+{
+    const QRegularExpressionMatch match = SizeValueRegular.match(value);
+    if (!match.hasMatch()) {
+        return false;
+    }
+
+    double bytes = match.captured(1).toDouble();
+    const QString unit = match.captured(2);
+    if ("k" == unit) {
+        bytes *= KB_COUNT;
+    } else if ("m" == unit) {
+        bytes *= MB_COUNT;
+    } else if ("g" == unit) {
+        bytes *= GB_COUNT;
+    } else if ("t" == unit) {
+        bytes *= TB_COUNT;
+    }
+    // 超出qint64范围时转换结果未定义，视为无效条件
+    if (!(bytes < double(std::numeric_limits<qint64>::max()))) {
+        return false;
+    }
+    const qint64 size = qint64(bytes);
+
+    // 多个条件取交集
+    if (">" == op) {
+        range->min = qMax(range->min, size + 1);
+    } else if (">=" == op) {
+        range->min = qMax(range->min, size);
+    } else if ("<" == op) {
+        range->max = qMin(range->max, size - 1);
+    } else if ("<=" == op) {
+        range->max = qMin(range->max, size);
+    } else if ("=" == op || ":" == op) {
+        range->min = qMax(range->min, size);
+        range->max = qMin(range->max, size);
+    }
+    return true;
+}
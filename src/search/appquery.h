@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QStringList>
+
+// 搜索查询语句
+// 由过滤条件和普通搜索词组成，以空白分隔，如：
+// installed:yes arch:i386 size>500M repo:spark held:yes gui: 编辑器
+// 过滤条件：
+//     installed/held/gui:yes|no（值为空时为yes）
+//     arch:架构[,架构...]
+//     repo:仓库地址中包含的字符串[,...]
+//     size/pkgsize 比较运算符(>, >=, <, <=, =) 容量（可带K/M/G/T单位）
+// 无法识别的部分作为普通搜索词
+class AppQuery
+{
+public:
+    // 三态布尔条件
+    enum BoolCondition {
+        Any = 0,
+        Yes,
+        No
+    };
+
+    // 容量范围，单位为字节，包含边界
+    struct SizeRange {
+        qint64 min;
+        qint64 max;
+        SizeRange();
+        bool isLimited() const;
+    };
+
+    explicit AppQuery(const QString &text);
+
+    // 是否包含过滤条件
+    bool hasFilters() const;
+    // 去掉过滤条件后的普通搜索词
+    QString getFreeText() const;
+
+    BoolCondition getInstalledCondition() const;
+    BoolCondition getHeldCondition() const;
+    BoolCondition getGuiCondition() const;
+    QStringList getArchList() const;
+    QStringList getRepoList() const;
+    SizeRange getInstalledSizeRange() const;
+    SizeRange getPkgSizeRange() const;
+
+private:
+    // 解析一个查询项，不是过滤条件时返回false
+    bool parseTerm(const QString &term);
+    static bool parseBoolCondition(const QString &value, BoolCondition *condition);
+    static bool parseSizeCondition(const QString &op, const QString &value, SizeRange *range);
+
+private:
+    bool m_hasFilters;
+    QString m_freeText;
+    BoolCondition m_installedCondition;
+    BoolCondition m_heldCondition;
+    BoolCondition m_guiCondition;
+    QStringList m_archList;
+    QStringList m_repoList;
+    SizeRange m_installedSizeRange;
+    SizeRange m_pkgSizeRange;
+};
@@ -0,0 +1,517 @@
+#include "appsearchindex.h"
+#include "fuzzymatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace AM;
+
+// 三元组由三个UTF-16字符组成
+#define TRIGRAM_CHAR_COUNT 3
+
+// 过滤属性标志位
+#define ATTRIBUTE_FLAG_INSTALLED 0x1
+#define ATTRIBUTE_FLAG_HELD 0x2
+#define ATTRIBUTE_FLAG_GUI 0x4
+
+// 获取字符串在字典中对应的位，不存在时添加
+// 共用最后一位的字符串加入foldedStrList，过滤时需逐个比较
+template <typename Mask>
+static Mask getDictionaryBit(QStringList &dictionary, const QString &str, QStringList &foldedStrList)
+{
+    const int maxBitCount = int(sizeof(Mask) * 8);
+    int index = dictionary.indexOf(str);
+    if (-1 == index) {
+        dictionary.append(str);
+        index = dictionary.size() - 1;
+    }
+    if (maxBitCount - 1 <= index && !foldedStrList.contains(str)) {
+        foldedStrList.append(str);
+    }
+    return Mask(1) << qMin(index, maxBitCount - 1);
+}
+
+// 根据查询中的字符串列表获取字典位掩码
+template <typename Mask>
+static Mask getDictionaryMask(const QStringList &dictionary, const QStringList &strList, bool isContainsMatch)
+{
+    const int maxBitCount = int(sizeof(Mask) * 8);
+    Mask mask = 0;
+    for (int i = 0; i < dictionary.size(); ++i) {
+        for (const QString &str : strList) {
+            if (isContainsMatch ? dictionary.at(i).contains(str, Qt::CaseInsensitive)
+                    : 0 == dictionary.at(i).compare(str, Qt::CaseInsensitive)) {
+                mask |= Mask(1) << qMin(i, maxBitCount - 1);
+                break;
+            }
+        }
+    }
+    return mask;
+}
+
+// 条目的位掩码是否匹配过滤计划，只有共用的最后一位匹配时，比较条目中共用该位的字符串
+template <typename Mask>
+static bool isDictionaryMatched(Mask entryMask, Mask planMask, const QStringList &foldedStrList,
+                                const QStringList &strList, bool isContainsMatch)
+{
+    const Mask lastBit = Mask(1) << (sizeof(Mask) * 8 - 1);
+    const Mask matchedMask = entryMask & planMask;
+    if (matchedMask & ~lastBit) {
+        return true;
+    }
+    if (!(matchedMask & lastBit)) {
+        return false;
+    }
+    for (const QString &foldedStr : foldedStrList) {
+        for (const QString &str : strList) {
+            if (isContainsMatch ? foldedStr.contains(str, Qt::CaseInsensitive)
+                    : 0 == foldedStr.compare(str, Qt::CaseInsensitive)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 设置过滤计划中的标志位条件
+static void setFlagCondition(AppSearchIndex::FilterPlan &plan, quint8 flag, AppQuery::BoolCondition condition)
+{
+    if (AppQuery::Any == condition) {
+        return;
+    }
+    plan.flagsMask |= flag;
+    if (AppQuery::Yes == condition) {
+        plan.flagsValue |= flag;
+    }
+}
+
+// 将三个字符打包为一个三元组键值
+static inline quint64 packTrigram(const QChar *chars)
+{
+    return (quint64(chars[0].unicode()) << 32)
+            | (quint64(chars[1].unicode()) << 16)
+            | quint64(chars[2].unicode());
+}
+
+AppSearchIndex::FilterPlan::FilterPlan()
+    : isEmpty(true)
+    , flagsMask(0)
+    , flagsValue(0)
+    , isArchLimited(false)
+    , archMask(0)
+    , isRepoLimited(false)
+    , repoMask(0)
+{
+}
+
+AppSearchIndex::AppSearchIndex()
+    : m_revision(0)
+{
+}
+
+AppSearchIndex::Pattern AppSearchIndex::createPattern(const QString &matchingText)
+{
+    Pattern pattern;
+    pattern.text = matchingText;
+    for (const QChar &character : matchingText) {
+        if (0x7f < character.unicode()) {
+            return pattern;
+        }
+    }
+    pattern.ascii = matchingText.toLatin1();
+    return pattern;
+}
+
+AppSearchIndex::FilterPlan AppSearchIndex::compileFilterPlan(const AppQuery &query) const
+{
+    FilterPlan plan;
+    if (!query.hasFilters()) {
+        return plan;
+    }
+
+    plan.isEmpty = false;
+    setFlagCondition(plan, ATTRIBUTE_FLAG_INSTALLED, query.getInstalledCondition());
+    setFlagCondition(plan, ATTRIBUTE_FLAG_HELD, query.getHeldCondition());
+    setFlagCondition(plan, ATTRIBUTE_FLAG_GUI, query.getGuiCondition());
+    plan.installedSizeRange = query.getInstalledSizeRange();
+    plan.pkgSizeRange = query.getPkgSizeRange();
+    if (!query.getArchList().isEmpty()) {
+        plan.isArchLimited = true;
+        plan.archList = query.getArchList();
+        plan.archMask = getDictionaryMask<quint32>(m_archList, plan.archList, false);
+    }
+    if (!query.getRepoList().isEmpty()) {
+        plan.isRepoLimited = true;
+        plan.repoList = query.getRepoList();
+        plan.repoMask = getDictionaryMask<quint64>(m_repoList, plan.repoList, true);
+    }
+    return plan;
+}
+
+bool AppSearchIndex::isFilterMatched(int id, const FilterPlan &plan) const
+{
+    if (plan.isEmpty) {
+        return true;
+    }
+
+    const qint64 installedSize = m_installedSizeColumn.at(id);
+    const qint64 pkgSize = m_pkgSizeColumn.at(id);
+    return (m_flagsColumn.at(id) & plan.flagsMask) == plan.flagsValue
+            && plan.installedSizeRange.min <= installedSize && installedSize <= plan.installedSizeRange.max
+            && plan.pkgSizeRange.min <= pkgSize && pkgSize <= plan.pkgSizeRange.max
+            && (!plan.isArchLimited || isDictionaryMatched<quint32>(m_archMaskColumn.at(id), plan.archMask,
+                                                                    m_foldedArchMap.value(id), plan.archList, false))
+            && (!plan.isRepoLimited || isDictionaryMatched<quint64>(m_repoMaskColumn.at(id), plan.repoMask,
+                                                                    m_foldedRepoMap.value(id), plan.repoList, true));
+}
+
+void AppSearchIndex::clear()
+{
+    ++m_revision;
+    m_entries.clear();
+    m_pkgNameTable.clear();
+    m_flagsColumn.clear();
+    m_installedSizeColumn.clear();
+    m_pkgSizeColumn.clear();
+    m_archMaskColumn.clear();
+    m_repoMaskColumn.clear();
+    m_archList.clear();
+    m_repoList.clear();
+    m_foldedArchMap.clear();
+    m_foldedRepoMap.clear();
+    m_entryIdMap.clear();
+    m_postingsMap.clear();
+}
+
+int AppSearchIndex::size() const
+{
+    return m_entries.size();
+}
+
+int AppSearchIndex::getRevision() const
+{
+    return m_revision;
+}
+
+void AppSearchIndex::updateApp(const AppInfo &appInfo)
+{
+    if (appInfo.pkgName.isEmpty()) {
+        return;
+    }
+
+    ++m_revision;
+    const QVector<quint64> newTrigrams = getTrigrams(appInfo.searchKeys);
+
+    int id = m_entryIdMap.value(appInfo.pkgName, -1);
+    if (-1 == id) {
+        // 新条目，id递增，直接追加到倒排列表末尾
+        id = m_entries.size();
+        Entry entry;
+        entry.pkgName = appInfo.pkgName;
+        entry.keys = appInfo.searchKeys;
+        entry.trigrams = newTrigrams;
+        m_entries.append(entry);
+        m_pkgNameTable.append(appInfo.searchKeys.pkgNameLower.toLatin1());
+        m_flagsColumn.append(0);
+        m_installedSizeColumn.append(0);
+        m_pkgSizeColumn.append(0);
+        m_archMaskColumn.append(0);
+        m_repoMaskColumn.append(0);
+        updateAttributes(id, appInfo);
+        m_entryIdMap.insert(appInfo.pkgName, id);
+
+        for (const quint64 trigram : newTrigrams) {
+            addToPostings(trigram, id);
+        }
+        return;
+    }
+
+    // 已有条目，只更新变化的三元组
+    Entry &entry = m_entries[id];
+    const QVector<quint64> oldTrigrams = entry.trigrams;
+    QVector<quint64> removedTrigrams;
+    QVector<quint64> addedTrigrams;
+    std::set_difference(oldTrigrams.cbegin(), oldTrigrams.cend(),
+                        newTrigrams.cbegin(), newTrigrams.cend(),
+                        std::back_inserter(removedTrigrams));
+    std::set_difference(newTrigrams.cbegin(), newTrigrams.cend(),
+                        oldTrigrams.cbegin(), oldTrigrams.cend(),
+                        std::back_inserter(addedTrigrams));
+
+    for (const quint64 trigram : removedTrigrams) {
+        removeFromPostings(trigram, id);
+    }
+    for (const quint64 trigram : addedTrigrams) {
+        addToPostings(trigram, id);
+    }
+
+    // 包名与条目一一对应，不会变化，无需更新名称表
+    entry.keys = appInfo.searchKeys;
+    entry.trigrams = newTrigrams;
+    updateAttributes(id, appInfo);
+}
+
+void AppSearchIndex::updateAppAttributes(const AppInfo &appInfo)
+{
+    const int id = m_entryIdMap.value(appInfo.pkgName, -1);
+    if (-1 == id) {
+        updateApp(appInfo);
+        return;
+    }
+
+    ++m_revision;
+    updateAttributes(id, appInfo);
+}
+
+QVector<int> AppSearchIndex::getCandidateIdList(const Pattern &pattern) const
+{
+    QVector<int> candidateIdList;
+    // 不足一个三元组时，无法使用索引，需逐个校验
+    if (TRIGRAM_CHAR_COUNT > pattern.text.size()) {
+        candidateIdList.reserve(m_entries.size());
+        for (int id = 0; id < m_entries.size(); ++id) {
+            candidateIdList.append(id);
+        }
+        return candidateIdList;
+    }
+
+    // 包名匹配的条目，直接扫描名称表
+    QVector<int> pkgNameMatchedIdList;
+    if (!pattern.ascii.isEmpty()) {
+        pkgNameMatchedIdList = m_pkgNameTable.findAll(pattern.ascii);
+    }
+
+    QVector<quint64> queryTrigrams;
+    appendTrigrams(queryTrigrams, pattern.text);
+    std::sort(queryTrigrams.begin(), queryTrigrams.end());
+    queryTrigrams.erase(std::unique(queryTrigrams.begin(), queryTrigrams.end()), queryTrigrams.end());
+
+    // 获取各三元组的倒排列表，任一不存在则应用名和拼音均无匹配项
+    QVector<const QVector<int> *> postingsList;
+    for (const quint64 trigram : queryTrigrams) {
+        QHash<quint64, QVector<int>>::const_iterator cIter = m_postingsMap.constFind(trigram);
+        if (m_postingsMap.cend() == cIter) {
+            return pkgNameMatchedIdList;
+        }
+        postingsList.append(&cIter.value());
+    }
+
+    // 从最短的倒排列表开始求交集
+    std::sort(postingsList.begin(), postingsList.end(), [](const QVector<int> *a, const QVector<int> *b) {
+        return a->size() < b->size();
+    });
+    candidateIdList = *postingsList.first();
+    for (int i = 1; i < postingsList.size() && !candidateIdList.isEmpty(); ++i) {
+        QVector<int> intersectedIdList;
+        std::set_intersection(candidateIdList.cbegin(), candidateIdList.cend(),
+                              postingsList[i]->cbegin(), postingsList[i]->cend(),
+                              std::back_inserter(intersectedIdList));
+        candidateIdList.swap(intersectedIdList);
+    }
+
+    // 三元组可能分布在不同关键字中，候选项需再校验
+    QVector<int> unitedIdList;
+    std::set_union(pkgNameMatchedIdList.cbegin(), pkgNameMatchedIdList.cend(),
+                   candidateIdList.cbegin(), candidateIdList.cend(),
+                   std::back_inserter(unitedIdList));
+    return unitedIdList;
+}
+
+bool AppSearchIndex::isMatched(int id, const Pattern &pattern) const
+{
+    return isPkgNameMatched(id, pattern) || isKeysMatched(m_entries.at(id).keys, pattern.text);
+}
+
+int AppSearchIndex::getMatchRank(int id, const Pattern &pattern) const
+{
+    const AppSearchKeys &keys = m_entries.at(id).keys;
+    const char *pkgName = m_pkgNameTable.getName(id);
+    const int pkgNameLength = m_pkgNameTable.getNameLength(id);
+    const bool isAscii = !pattern.ascii.isEmpty();
+    // 名称完全相同
+    if ((isAscii && pkgNameLength == pattern.ascii.size() && 0 == memcmp(pkgName, pattern.ascii.constData(), size_t(pkgNameLength)))
+            || keys.appNameLower == pattern.text) {
+        return 0;
+    }
+    // 名称前缀相同
+    if ((isAscii && pkgNameLength >= pattern.ascii.size() && 0 == memcmp(pkgName, pattern.ascii.constData(), size_t(pattern.ascii.size())))
+            || keys.appNameLower.startsWith(pattern.text)) {
+        return 1;
+    }
+    // 名称包含
+    if (isPkgNameMatched(id, pattern) || keys.appNameLower.contains(pattern.text)) {
+        return 2;
+    }
+    // 拼音匹配
+    return 3;
+}
+
+QString AppSearchIndex::getPkgName(int id) const
+{
+    return m_entries.at(id).pkgName;
+}
+
+int AppSearchIndex::getId(const QString &pkgName) const
+{
+    return m_entryIdMap.value(pkgName, -1);
+}
+
+QVector<FuzzyMatchedId> AppSearchIndex::getFuzzyMatchedIdList(const Pattern &pattern, const QVector<int> &excludedIdList) const
+{
+    QVector<FuzzyMatchedId> matchedIdList;
+    // 包名均为ASCII字符，含其他字符的搜索词不做模糊匹配
+    if (pattern.ascii.isEmpty()) {
+        return matchedIdList;
+    }
+
+    const int maxDistance = FuzzyMatcher::getMaxDistance(pattern.ascii.size());
+    const FuzzyMatcher matcher(pattern.ascii);
+    if (0 > maxDistance || !matcher.isValid()) {
+        return matchedIdList;
+    }
+
+    QVector<int>::const_iterator excludedIter = excludedIdList.cbegin();
+    for (int id = 0; id < m_entries.size(); ++id) {
+        while (excludedIdList.cend() != excludedIter && *excludedIter < id) {
+            ++excludedIter;
+        }
+        if (excludedIdList.cend() != excludedIter && *excludedIter == id) {
+            continue;
+        }
+
+        FuzzyMatchedId matchedId;
+        matchedId.id = id;
+        if (matcher.match(m_pkgNameTable.getName(id), m_pkgNameTable.getNameLength(id), maxDistance,
+                          &matchedId.distance, &matchedId.position)) {
+            matchedIdList.append(matchedId);
+        }
+    }
+
+    std::stable_sort(matchedIdList.begin(), matchedIdList.end(), [](const FuzzyMatchedId &a, const FuzzyMatchedId &b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        return a.position < b.position;
+    });
+    return matchedIdList;
+}
+
+void AppSearchIndex::appendTrigrams(QVector<quint64> &trigrams, const QString &str)
+{
+    const QChar *chars = str.constData();
+    for (int i = 0; i + TRIGRAM_CHAR_COUNT <= str.size(); ++i) {
+        trigrams.append(packTrigram(chars + i));
+    }
+}
+
+QVector<quint64> AppSearchIndex::getTrigrams(const AppSearchKeys &keys)
+{
+    QVector<quint64> trigrams;
+    appendTrigrams(trigrams, keys.appNameLower);
+    appendTrigrams(trigrams, keys.noTonePinYin);
+    appendTrigrams(trigrams, keys.simpliyiedPinYin);
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+bool AppSearchIndex::isKeysMatched(const AppSearchKeys &keys, const QString &matchingText)
+{
+    // 应用名称对应的无声调拼音
+    return keys.noTonePinYin.contains(matchingText)
+            // 应用名称拼音首字母缩写
+            || keys.simpliyiedPinYin.contains(matchingText)
+            // 匹配应用名称
+            || keys.appNameLower.contains(matchingText);
+}
+
+bool AppSearchIndex::isPkgNameMatched(int id, const Pattern &pattern) const
+{
+    // 包名均为ASCII字符
+    return !pattern.ascii.isEmpty() && m_pkgNameTable.contains(id, pattern.ascii);
+}
+
+void AppSearchIndex::updateAttributes(int id, const AppInfo &appInfo)
+{
+    quint8 flags = 0;
+    if (appInfo.isInstalled) {
+        flags |= ATTRIBUTE_FLAG_INSTALLED;
+    }
+    if (appInfo.installedPkgInfo.isHoldVersion) {
+        flags |= ATTRIBUTE_FLAG_HELD;
+    }
+    if (!appInfo.desktopInfo.desktopPath.isEmpty()) {
+        flags |= ATTRIBUTE_FLAG_GUI;
+    }
+    m_flagsColumn[id] = flags;
+
+    // 已安装时使用已安装包的容量，否则使用仓库中第一个包的容量
+    const PkgInfo &pkgInfo = (appInfo.isInstalled || appInfo.pkgInfoList.isEmpty())
+            ? appInfo.installedPkgInfo : appInfo.pkgInfoList.first();
+    m_installedSizeColumn[id] = qint64(pkgInfo.installedSize) * KB_COUNT;
+    m_pkgSizeColumn[id] = pkgInfo.pkgSize;
+
+    quint32 archMask = 0;
+    quint64 repoMask = 0;
+    QStringList foldedArchList;
+    QStringList foldedRepoList;
+    if (!appInfo.installedPkgInfo.arch.isEmpty()) {
+        archMask |= getDictionaryBit<quint32>(m_archList, appInfo.installedPkgInfo.arch, foldedArchList);
+    }
+    for (const PkgInfo &srvPkgInfo : appInfo.pkgInfoList) {
+        if (!srvPkgInfo.arch.isEmpty()) {
+            archMask |= getDictionaryBit<quint32>(m_archList, srvPkgInfo.arch, foldedArchList);
+        }
+        if (!srvPkgInfo.depositoryUrl.isEmpty()) {
+            repoMask |= getDictionaryBit<quint64>(m_repoList, srvPkgInfo.depositoryUrl, foldedRepoList);
+        }
+    }
+    m_archMaskColumn[id] = archMask;
+    m_repoMaskColumn[id] = repoMask;
+    // 共用最后一位的很少，只记录有的条目
+    if (foldedArchList.isEmpty()) {
+        m_foldedArchMap.remove(id);
+    } else {
+        m_foldedArchMap.insert(id, foldedArchList);
+    }
+    if (foldedRepoList.isEmpty()) {
+        m_foldedRepoMap.remove(id);
+    } else {
+        m_foldedRepoMap.insert(id, foldedRepoList);
+    }
+}
+
+void AppSearchIndex::addToPostings(quint64 trigram, int id)
+{
+    QVector<int> &postings = m_postingsMap[trigram];
+    // 加载时id递增，大多数情况直接追加
+    if (postings.isEmpty() || postings.last() < id) {
+        postings.append(id);
+        return;
+    }
+
+    QVector<int>::iterator iter = std::lower_bound(postings.begin(), postings.end(), id);
+    if (postings.end() == iter || *iter != id) {
+        postings.insert(iter, id);
+    }
+}
+
+void AppSearchIndex::removeFromPostings(quint64 trigram, int id)
+{
+    QHash<quint64, QVector<int>>::iterator postingsIter = m_postingsMap.find(trigram);
+    if (m_postingsMap.end() == postingsIter) {
+        return;
+    }
+
+    QVector<int> &postings = postingsIter.value();
+    QVector<int>::iterator iter = std::lower_bound(postings.begin(), postings.end(), id);
+    if (postings.end() != iter && *iter == id) {
+        postings.erase(iter);
+    }
+
+    if (postings.isEmpty()) {
+        m_postingsMap.erase(postingsIter);
+    }
+}
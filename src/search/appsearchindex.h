@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../common/appmanagercommon.h"
+#include "asciinametable.h"
+#include "appquery.h"
+
+#include <QHash>
+#include <QVector>
+
+// 模糊匹配结果项
+struct FuzzyMatchedId {
+    int id;
+    int distance; // 编辑距离
+    int position; // 匹配位置
+};
+
+// 应用搜索索引
+// 包名存放在ASCII名称表中直接扫描；应用名和拼音关键字建立三元组(trigram)倒排索引，
+// 搜索时先求各三元组倒排列表的交集，再校验候选项
+class AppSearchIndex
+{
+public:
+    // 预处理后的搜索词，避免校验每个条目时重复转换
+    struct Pattern {
+        QString text; // 小写搜索词
+        QByteArray ascii; // 小写ASCII搜索词，含非ASCII字符时为空
+    };
+
+    // 编译后的过滤计划，各条件合并为标志位掩码、容量范围和架构/仓库位掩码，
+    // 对每个条目只需一次比较
+    struct FilterPlan {
+        bool isEmpty; // 无过滤条件
+        quint8 flagsMask; // 需比较的标志位
+        quint8 flagsValue; // 标志位期望值
+        AppQuery::SizeRange installedSizeRange;
+        AppQuery::SizeRange pkgSizeRange;
+        bool isArchLimited;
+        quint32 archMask; // 任一位匹配即可
+        QStringList archList; // 只有共用的最后一位匹配时逐个比较
+        bool isRepoLimited;
+        quint64 repoMask; // 任一位匹配即可
+        QStringList repoList;
+        FilterPlan();
+    };
+
+    AppSearchIndex();
+
+    // matchingText需已转换为小写
+    static Pattern createPattern(const QString &matchingText);
+    // 将查询语句中的过滤条件编译为过滤计划
+    FilterPlan compileFilterPlan(const AppQuery &query) const;
+    // 条目属性是否满足过滤计划
+    bool isFilterMatched(int id, const FilterPlan &plan) const;
+
+    void clear();
+    int size() const;
+    // 索引版本，每次修改后递增，用于判断上次搜索结果是否仍然有效
+    int getRevision() const;
+    // 添加或更新应用的搜索关键字
+    void updateApp(const AM::AppInfo &appInfo);
+    // 只更新应用的过滤属性（仓库包信息变化时），关键字不变
+    void updateAppAttributes(const AM::AppInfo &appInfo);
+
+    // 获取候选条目id列表（有序），搜索词不足一个三元组时返回全部条目
+    QVector<int> getCandidateIdList(const Pattern &pattern) const;
+    // 校验条目是否匹配
+    bool isMatched(int id, const Pattern &pattern) const;
+    // 获取条目匹配等级，值越小越靠前
+    int getMatchRank(int id, const Pattern &pattern) const;
+    QString getPkgName(int id) const;
+    // 获取包名对应的条目id，不存在时返回-1
+    int getId(const QString &pkgName) const;
+    // 按编辑距离模糊匹配包名，跳过已精确匹配的条目（excludedIdList需有序），
+    // 结果按编辑距离和匹配位置排序
+    QVector<FuzzyMatchedId> getFuzzyMatchedIdList(const Pattern &pattern, const QVector<int> &excludedIdList) const;
+
+private:
+    // 索引条目
+    struct Entry {
+        QString pkgName;
+        AM::AppSearchKeys keys;
+        QVector<quint64> trigrams; // 应用名和拼音的三元组，有序且无重复
+    };
+
+    // 获取字符串中的三元组
+    static void appendTrigrams(QVector<quint64> &trigrams, const QString &str);
+    static QVector<quint64> getTrigrams(const AM::AppSearchKeys &keys);
+    // 校验应用名和拼音关键字是否匹配
+    static bool isKeysMatched(const AM::AppSearchKeys &keys, const QString &matchingText);
+    // 校验包名是否匹配
+    bool isPkgNameMatched(int id, const Pattern &pattern) const;
+
+    // 更新条目的过滤属性列
+    void updateAttributes(int id, const AM::AppInfo &appInfo);
+
+    void addToPostings(quint64 trigram, int id);
+    void removeFromPostings(quint64 trigram, int id);
+
+private:
+    int m_revision;
+    QVector<Entry> m_entries;
+    AsciiNameTable m_pkgNameTable; // 条目id -> 小写包名
+    QHash<QString, int> m_entryIdMap; // 包名 -> 条目id
+    QHash<quint64, QVector<int>> m_postingsMap; // 三元组 -> 有序的条目id列表
+
+    // 过滤属性，按列存放，下标为条目id
+    QVector<quint8> m_flagsColumn;
+    QVector<qint64> m_installedSizeColumn; // 字节
+    QVector<qint64> m_pkgSizeColumn; // 字节
+    QVector<quint32> m_archMaskColumn;
+    QVector<quint64> m_repoMaskColumn;
+    // 位 -> 架构/仓库地址，超出位数时多余项共用最后一位
+    QStringList m_archList;
+    QStringList m_repoList;
+    // 条目id -> 共用最后一位的架构/仓库地址，过滤时精确比较，避免误匹配
+    QHash<int, QStringList> m_foldedArchMap;
+    QHash<int, QStringList> m_foldedRepoMap;
+};
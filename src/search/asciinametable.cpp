@@ -0,0 +1,170 @@
+#include "asciinametable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ASCII_NAME_TABLE_X86
+#endif
+
+// 中间字节比较，首尾字节已由过滤条件保证相等
+static inline bool isMiddleEqual(const char *str, const char *pattern, int patternLength)
+{
+    return 2 >= patternLength || 0 == memcmp(str + 1, pattern + 1, size_t(patternLength - 2));
+}
+
+static const char *findSubstringScalar(const char *str, int length, const char *pattern, int patternLength)
+{
+    return static_cast<const char *>(memmem(str, size_t(length), pattern, size_t(patternLength)));
+}
+
+#ifdef ASCII_NAME_TABLE_X86
+// 每次比较32个位置的首尾字节，都相等的位置再比较中间字节
+__attribute__((target("avx2")))
+static const char *findSubstringAvx2(const char *str, int length, const char *pattern, int patternLength)
+{
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[patternLength - 1]);
+    int i = 0;
+    for (; i + patternLength - 1 + 32 <= length; i += 32) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + i + patternLength - 1));
+        quint32 mask = quint32(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                                                                     _mm256_cmpeq_epi8(last, blockLast))));
+        while (0 != mask) {
+            const int pos = i + __builtin_ctz(mask);
+            if (isMiddleEqual(str + pos, pattern, patternLength)) {
+                return str + pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findSubstringScalar(str + i, length - i, pattern, patternLength);
+}
+
+#ifdef __SSE2__
+// 每次比较16个位置的首尾字节
+static const char *findSubstringSse2(const char *str, int length, const char *pattern, int patternLength)
+{
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[patternLength - 1]);
+    int i = 0;
+    for (; i + patternLength - 1 + 16 <= length; i += 16) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str + i + patternLength - 1));
+        quint32 mask = quint32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst),
+                                                               _mm_cmpeq_epi8(last, blockLast))));
+        while (0 != mask) {
+            const int pos = i + __builtin_ctz(mask);
+            if (isMiddleEqual(str + pos, pattern, patternLength)) {
+                return str + pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findSubstringScalar(str + i, length - i, pattern, patternLength);
+}
+#endif
+#endif
+
+typedef const char *(*FindSubstringFunc)(const char *, int, const char *, int);
+
+// 根据CPU支持的指令集选择实现
+static FindSubstringFunc selectFindSubstringFunc()
+{
+#ifdef ASCII_NAME_TABLE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findSubstringAvx2;
+    }
+#ifdef __SSE2__
+    return findSubstringSse2;
+#endif
+#endif
+    return findSubstringScalar;
+}
+
+static const FindSubstringFunc FindSubstringImpl = selectFindSubstringFunc();
+
+AsciiNameTable::AsciiNameTable()
+{
+}
+
+void AsciiNameTable::clear()
+{
+    m_blob.clear();
+    m_offsets.clear();
+}
+
+int AsciiNameTable::size() const
+{
+    return m_offsets.size();
+}
+
+int AsciiNameTable::append(const QByteArray &lowerName)
+{
+    m_offsets.append(m_blob.size());
+    m_blob.append(lowerName);
+    m_blob.append('\0');
+    return m_offsets.size() - 1;
+}
+
+const char *AsciiNameTable::getName(int id) const
+{
+    return m_blob.constData() + m_offsets.at(id);
+}
+
+int AsciiNameTable::getNameLength(int id) const
+{
+    const int end = (id + 1 < m_offsets.size()) ? m_offsets.at(id + 1) : m_blob.size();
+    // 去掉分隔符
+    return end - m_offsets.at(id) - 1;
+}
+
+bool AsciiNameTable::contains(int id, const QByteArray &pattern) const
+{
+    if (pattern.isEmpty()) {
+        return true;
+    }
+    return nullptr != findSubstring(getName(id), getNameLength(id), pattern.constData(), pattern.size());
+}
+
+QVector<int> AsciiNameTable::findAll(const QByteArray &pattern) const
+{
+    QVector<int> idList;
+    if (pattern.isEmpty()) {
+        idList.reserve(m_offsets.size());
+        for (int id = 0; id < m_offsets.size(); ++id) {
+            idList.append(id);
+        }
+        return idList;
+    }
+
+    // 名称间以'\0'分隔，子串不会跨越名称，直接扫描整块数据
+    const char *blobBegin = m_blob.constData();
+    const char *blobEnd = blobBegin + m_blob.size();
+    const char *cursor = blobBegin;
+    while (cursor < blobEnd) {
+        const char *found = findSubstring(cursor, int(blobEnd - cursor), pattern.constData(), pattern.size());
+        if (nullptr == found) {
+            break;
+        }
+
+        const int id = int(std::upper_bound(m_offsets.cbegin(), m_offsets.cend(), int(found - blobBegin))
+                           - m_offsets.cbegin()) - 1;
+        idList.append(id);
+        // 同一名称只记录一次，从下一个名称继续查找
+        cursor = (id + 1 < m_offsets.size()) ? (blobBegin + m_offsets.at(id + 1)) : blobEnd;
+    }
+
+    return idList;
+}
+
+const char *AsciiNameTable::findSubstring(const char *str, int length, const char *pattern, int patternLength)
+{
+    if (0 >= patternLength || length < patternLength) {
+        return nullptr;
+    }
+    return FindSubstringImpl(str, length, pattern, patternLength);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+// ASCII名称表
+// 小写名称以'\0'分隔连续存放，配合偏移表定位，
+// 子串查找使用SIMD首尾字节过滤（AVX2/SSE2，其他平台使用标量实现）
+class AsciiNameTable
+{
+public:
+    AsciiNameTable();
+
+    void clear();
+    int size() const;
+    // 追加名称，返回名称id
+    int append(const QByteArray &lowerName);
+
+    const char *getName(int id) const;
+    int getNameLength(int id) const;
+
+    // 名称是否包含子串
+    bool contains(int id, const QByteArray &pattern) const;
+    // 查找包含子串的全部名称id（有序）
+    QVector<int> findAll(const QByteArray &pattern) const;
+
+    // 在字符串中查找子串，返回首次出现的位置，不存在时返回nullptr
+    static const char *findSubstring(const char *str, int length, const char *pattern, int patternLength);
+
+private:
+    QByteArray m_blob;
+    QVector<int> m_offsets; // 名称id -> 在m_blob中的起始位置
+};
@@ -0,0 +1,83 @@
+#include "fuzzymatcher.h"
+
+#include <cstring>
+
+FuzzyMatcher::FuzzyMatcher(const QByteArray &pattern)
+    : m_patternLength(pattern.size())
+{
+    memset(m_peqs, 0, sizeof(m_peqs));
+    if (!isValid()) {
+        return;
+    }
+
+    for (int i = 0; i < m_patternLength; ++i) {
+        m_peqs[uchar(pattern.at(i))] |= quint64(1) << i;
+    }
+}
+
+bool FuzzyMatcher::isValid() const
+{
+    return 0 < m_patternLength && FUZZY_PATTERN_MAX_LENGTH >= m_patternLength;
+}
+
+bool FuzzyMatcher::match(const char *text, int textLength, int maxDistance, int *distance, int *position) const
+{
+    if (!isValid()) {
+        return false;
+    }
+
+    // 垂直方向的正负增量，初始时第0列各行距离依次递增
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    const quint64 highBit = quint64(1) << (m_patternLength - 1);
+    int score = m_patternLength;
+    int bestScore = maxDistance + 1;
+    int bestEnd = -1;
+
+    for (int j = 0; j < textLength; ++j) {
+        const quint64 eq = m_peqs[uchar(text[j])];
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+        if (ph & highBit) {
+            ++score;
+        } else if (mh & highBit) {
+            --score;
+        }
+
+        // 子串匹配，第0行距离恒为0，不移入进位
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score < bestScore) {
+            bestScore = score;
+            bestEnd = j;
+            if (0 == bestScore) {
+                break;
+            }
+        }
+    }
+
+    if (-1 == bestEnd) {
+        return false;
+    }
+
+    *distance = bestScore;
+    *position = qMax(0, bestEnd - m_patternLength + 1);
+    return true;
+}
+
+int FuzzyMatcher::getMaxDistance(int patternLength)
+{
+    // 过短的搜索词容错后几乎匹配所有包，不做模糊匹配
+    if (4 > patternLength || FUZZY_PATTERN_MAX_LENGTH < patternLength) {
+        return -1;
+    }
+    if (6 > patternLength) {
+        return 1;
+    }
+    return 2;
+}
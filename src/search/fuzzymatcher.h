@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QByteArray>
+
+// 模式串最大长度，超过时不做模糊匹配
+#define FUZZY_PATTERN_MAX_LENGTH 64
+
+// 模糊匹配器
+// 使用Myers位并行算法，查找文本中与模式串编辑距离不超过上限的子串，
+// 模式串和文本均为小写ASCII字符串
+class FuzzyMatcher
+{
+public:
+    explicit FuzzyMatcher(const QByteArray &pattern);
+
+    bool isValid() const;
+    // 匹配文本，成功时输出最小编辑距离及对应子串的起始位置（近似值）
+    bool match(const char *text, int textLength, int maxDistance, int *distance, int *position) const;
+
+    // 根据模式串长度获取允许的最大编辑距离，返回-1时不做模糊匹配
+    static int getMaxDistance(int patternLength);
+
+private:
+    int m_patternLength;
+    quint64 m_peqs[256]; // 字符 -> 在模式串中出现位置的位掩码
+};
@@ -0,0 +1,248 @@
+#include "stallmonitor.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+// 延迟区间上限（毫秒），最后一个区间无上限
+static const QVector<qint64> LatencyBucketUpperBoundList = {
+    4, 8, 16, 33, 50, 100, 250, 500, 1000, 2000
+};
+
+Q_GLOBAL_STATIC(StallMonitor, GlobalStallMonitor)
+
+StallWatchdog::StallWatchdog(StallMonitor *monitor, QObject *parent)
+    : QThread(parent)
+    , m_monitor(monitor)
+{
+}
+
+StallWatchdog::~StallWatchdog()
+{
+}
+
+void StallWatchdog::run()
+{
+    while (!isInterruptionRequested()) {
+        msleep(STALL_MONITOR_WATCHDOG_INTERVAL_MS);
+        m_monitor->checkStall();
+    }
+}
+
+StallMonitor::StallMonitor()
+    : QObject(nullptr)
+    , m_heartbeatTimer(nullptr)
+    , m_watchdog(nullptr)
+    , m_lastBeatMs(0)
+    , m_currentSection(nullptr)
+    , m_stalledSection(nullptr)
+    , m_isStallReported(0)
+{
+    m_latencyCountList.fill(0, LatencyBucketUpperBoundList.size() + 1);
+    m_clock.start();
+}
+
+StallMonitor::~StallMonitor()
+{
+    stop();
+}
+
+StallMonitor *StallMonitor::instance()
+{
+    return GlobalStallMonitor();
+}
+
+bool StallMonitor::isEnabledByEnv()
+{
+    return !qgetenv(STALL_MONITOR_REPORT_ENV).isEmpty();
+}
+
+void StallMonitor::start()
+{
+    if (m_heartbeatTimer) {
+        return;
+    }
+
+    m_lastBeatMs.storeRelease(m_clock.elapsed());
+    m_heartbeatTimer = new QTimer(this);
+    m_heartbeatTimer->setTimerType(Qt::TimerType::PreciseTimer);
+    m_heartbeatTimer->setInterval(STALL_MONITOR_HEARTBEAT_INTERVAL_MS);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &StallMonitor::onHeartbeat);
+    m_heartbeatTimer->start();
+
+    m_watchdog = new StallWatchdog(this);
+    m_watchdog->start(QThread::Priority::LowPriority);
+    qInfo() << Q_FUNC_INFO << "stall threshold:" << STALL_MONITOR_STALL_THRESHOLD_MS << "ms";
+}
+
+void StallMonitor::stop()
+{
+    if (!m_heartbeatTimer) {
+        return;
+    }
+
+    m_watchdog->requestInterruption();
+    m_watchdog->wait();
+    delete m_watchdog;
+    m_watchdog = nullptr;
+
+    m_heartbeatTimer->stop();
+    delete m_heartbeatTimer;
+    m_heartbeatTimer = nullptr;
+
+    writeReportByEnv();
+}
+
+bool StallMonitor::isRunning() const
+{
+    return nullptr != m_heartbeatTimer;
+}
+
+QString StallMonitor::getReport() const
+{
+    QString report;
+    QTextStream stream(&report);
+
+    stream << "事件循环延迟分布（心跳间隔" << STALL_MONITOR_HEARTBEAT_INTERVAL_MS << "毫秒）\n";
+    quint64 totalCount = 0;
+    for (quint64 count : m_latencyCountList) {
+        totalCount += count;
+    }
+    qint64 lowerBound = 0;
+    for (int i = 0; i < m_latencyCountList.size(); ++i) {
+        const quint64 count = m_latencyCountList.at(i);
+        const QString range = (i < LatencyBucketUpperBoundList.size())
+                              ? QString("%1-%2ms").arg(lowerBound).arg(LatencyBucketUpperBoundList.at(i))
+                              : QString(">%1ms").arg(lowerBound);
+        const double percent = totalCount ? 100.0 * count / totalCount : 0;
+        stream << QString("  %1\t%2\t%3%\t%4\n").arg(range, -12).arg(count)
+               .arg(percent, 0, 'f', 1).arg(QString(int(std::ceil(percent / 2)), QChar('#')));
+        if (i < LatencyBucketUpperBoundList.size()) {
+            lowerBound = LatencyBucketUpperBoundList.at(i);
+        }
+    }
+
+    stream << "\n卡顿记录（超过" << STALL_MONITOR_STALL_THRESHOLD_MS << "毫秒，最近"
+           << m_stallRecordList.size() << "次）\n";
+    for (const StallRecord &record : m_stallRecordList) {
+        stream << "  " << record.time.toString("yyyy-MM-dd hh:mm:ss.zzz")
+               << "\t" << record.durationMs << "ms\t" << record.section << "\n";
+    }
+
+    // 按总耗时降序
+    QList<QString> sectionList = m_sectionStatMap.keys();
+    std::sort(sectionList.begin(), sectionList.end(), [this](const QString &a, const QString &b) {
+        return m_sectionStatMap.value(a).totalMs > m_sectionStatMap.value(b).totalMs;
+    });
+    stream << "\n处理函数耗时（超过" << STALL_MONITOR_STALL_THRESHOLD_MS << "毫秒的执行）\n";
+    for (const QString &section : sectionList) {
+        const SectionStat stat = m_sectionStatMap.value(section);
+        stream << "  " << section << "\n    次数：" << stat.count << "，总计：" << stat.totalMs
+               << "ms，最长：" << stat.maxMs << "ms\n";
+    }
+
+    stream.flush();
+    return report;
+}
+
+const char *StallMonitor::enterSection(const char *section)
+{
+    return m_currentSection.fetchAndStoreOrdered(section);
+}
+
+void StallMonitor::leaveSection(const char *previousSection, const char *section, qint64 durationMs)
+{
+    m_currentSection.storeRelease(previousSection);
+    // 未开启监测时不统计
+    if (!m_heartbeatTimer || STALL_MONITOR_STALL_THRESHOLD_MS > durationMs) {
+        return;
+    }
+
+    SectionStat &stat = m_sectionStatMap[QString::fromLatin1(section)];
+    ++stat.count;
+    stat.totalMs += durationMs;
+    stat.maxMs = qMax(stat.maxMs, durationMs);
+}
+
+void StallMonitor::checkStall()
+{
+    const qint64 stalledMs = m_clock.elapsed() - m_lastBeatMs.loadAcquire() - STALL_MONITOR_HEARTBEAT_INTERVAL_MS;
+    if (STALL_MONITOR_STALL_THRESHOLD_MS > stalledMs) {
+        return;
+    }
+    // 同一次卡顿只记录一次
+    if (!m_isStallReported.testAndSetOrdered(0, 1)) {
+        return;
+    }
+
+    const char *section = m_currentSection.loadAcquire();
+    m_stalledSection.storeRelease(section);
+    qWarning() << Q_FUNC_INFO << "GUI thread stalled over" << stalledMs << "ms in" << (section ? section : "unknown");
+}
+
+void StallMonitor::onHeartbeat()
+{
+    const qint64 nowMs = m_clock.elapsed();
+    const qint64 latencyMs = qMax(qint64(0), nowMs - m_lastBeatMs.loadAcquire() - STALL_MONITOR_HEARTBEAT_INTERVAL_MS);
+    m_lastBeatMs.storeRelease(nowMs);
+    addLatency(latencyMs);
+
+    if (STALL_MONITOR_STALL_THRESHOLD_MS <= latencyMs) {
+        StallRecord record;
+        record.time = QDateTime::currentDateTime();
+        record.durationMs = latencyMs;
+        const char *section = m_stalledSection.loadAcquire();
+        record.section = section ? QString::fromLatin1(section) : QString("unknown");
+        m_stallRecordList.append(record);
+        if (STALL_MONITOR_MAX_RECORD_COUNT < m_stallRecordList.size()) {
+            m_stallRecordList.removeFirst();
+        }
+    }
+
+    m_stalledSection.storeRelease(nullptr);
+    m_isStallReported.storeRelease(0);
+}
+
+void StallMonitor::addLatency(qint64 latencyMs)
+{
+    const int bucketIndex = int(std::lower_bound(LatencyBucketUpperBoundList.cbegin(), LatencyBucketUpperBoundList.cend(),
+                                                 latencyMs) - LatencyBucketUpperBoundList.cbegin());
+    ++m_latencyCountList[bucketIndex];
+}
+
+void StallMonitor::writeReportByEnv() const
+{
+    const QString reportPath = QString::fromLocal8Bit(qgetenv(STALL_MONITOR_REPORT_ENV));
+    if (reportPath.isEmpty()) {
+        return;
+    }
+
+    if ("-" == reportPath) {
+        qInfo().noquote() << getReport();
+        return;
+    }
+
+    QFile file(reportPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << Q_FUNC_INFO << "open" << reportPath << "failed";
+        return;
+    }
+    file.write(getReport().toUtf8());
+    file.close();
+}
+
+StallSection::StallSection(const char *section)
+    : m_section(section)
+    , m_previousSection(StallMonitor::instance()->enterSection(section))
+{
+    m_timer.start();
+}
+
+StallSection::~StallSection()
+{
+    StallMonitor::instance()->leaveSection(m_previousSection, m_section, m_timer.elapsed());
+}
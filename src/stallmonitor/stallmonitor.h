@@ -0,0 +1,134 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+
+class QTimer;
+
+// 心跳间隔（毫秒）
+#define STALL_MONITOR_HEARTBEAT_INTERVAL_MS 50
+// 看门狗检查间隔（毫秒）
+#define STALL_MONITOR_WATCHDOG_INTERVAL_MS 20
+// 事件循环延迟超过此值（毫秒）记为卡顿
+#define STALL_MONITOR_STALL_THRESHOLD_MS 100
+// 最多保留的卡顿记录数
+#define STALL_MONITOR_MAX_RECORD_COUNT 100
+// 设置此环境变量时，启动时即开启监测，退出时将统计报告写入其指定的文件，值为"-"时输出到日志
+#define STALL_MONITOR_REPORT_ENV "CCC_APP_MANAGER_STALL_REPORT"
+
+class StallMonitor;
+
+// 看门狗线程，心跳停止超过阈值时记录界面线程正在执行的处理函数
+class StallWatchdog : public QThread
+{
+    Q_OBJECT
+public:
+    explicit StallWatchdog(StallMonitor *monitor, QObject *parent = nullptr);
+    virtual ~StallWatchdog() override;
+
+protected:
+    virtual void run() override;
+
+private:
+    StallMonitor *m_monitor;
+};
+
+// 界面线程卡顿监测
+// 界面线程定时心跳，心跳实际间隔与设定间隔之差即事件循环延迟，按区间统计；
+// 看门狗线程发现心跳停止时，记录界面线程当前所在的处理函数（StallSection）
+// 心跳和看门狗会定时唤醒，默认不开启，只在设置了环境变量或从菜单开启时运行
+class StallMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    // 卡顿记录
+    struct StallRecord {
+        QDateTime time; // 卡顿结束时间
+        qint64 durationMs; // 卡顿时长
+        QString section; // 卡顿时所在的处理函数
+        StallRecord()
+        {
+            durationMs = 0;
+        }
+    };
+
+    // 处理函数耗时统计，只统计超过阈值的执行
+    struct SectionStat {
+        int count;
+        qint64 totalMs;
+        qint64 maxMs;
+        SectionStat()
+        {
+            count = 0;
+            totalMs = 0;
+            maxMs = 0;
+        }
+    };
+
+    StallMonitor();
+    virtual ~StallMonitor() override;
+
+    static StallMonitor *instance();
+
+    // 是否设置了报告环境变量，设置时启动即开启监测
+    static bool isEnabledByEnv();
+
+    // 在界面线程中调用
+    void start();
+    void stop();
+    bool isRunning() const;
+    // 生成统计报告
+    QString getReport() const;
+
+    // 以下由StallSection在界面线程中调用
+    const char *enterSection(const char *section);
+    void leaveSection(const char *previousSection, const char *section, qint64 durationMs);
+
+    // 由看门狗线程调用
+    void checkStall();
+
+private Q_SLOTS:
+    void onHeartbeat();
+
+private:
+    void addLatency(qint64 latencyMs);
+    // 写入环境变量指定的报告文件
+    void writeReportByEnv() const;
+
+private:
+    QElapsedTimer m_clock;
+    QTimer *m_heartbeatTimer;
+    StallWatchdog *m_watchdog;
+
+    // 界面线程与看门狗线程共享
+    QAtomicInteger<qint64> m_lastBeatMs; // 上次心跳时间
+    QAtomicPointer<const char> m_currentSection; // 界面线程当前所在的处理函数
+    QAtomicPointer<const char> m_stalledSection; // 看门狗发现卡顿时所在的处理函数
+    QAtomicInt m_isStallReported; // 本次卡顿是否已由看门狗记录
+
+    // 只在界面线程中访问
+    QVector<quint64> m_latencyCountList; // 各延迟区间的心跳次数
+    QList<StallRecord> m_stallRecordList;
+    QHash<QString, SectionStat> m_sectionStatMap; // 处理函数 -> 耗时统计
+};
+
+// 处理函数区间，构造时记录界面线程进入的处理函数，析构时恢复并统计耗时
+// 参数需为静态字符串，如Q_FUNC_INFO
+class StallSection
+{
+public:
+    explicit StallSection(const char *section);
+    ~StallSection();
+
+private:
+    const char *m_section;
+    const char *m_previousSection;
+    QElapsedTimer m_timer;
+};
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# 安装包下载任务测试，使用本地HTTP服务器
+# qmake && make check
+#
+#-------------------------------------------------
+
+QT       += core network testlib
+QT       -= gui
+
+TARGET = tst_pkgdownloadtask
+TEMPLATE = app
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    tst_pkgdownloadtask.cpp \
+    ../../src/download/pkgdownloadtask.cpp
+
+HEADERS += \
+    ../../src/download/pkgdownloadtask.h
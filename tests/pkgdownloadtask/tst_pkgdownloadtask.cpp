@@ -0,0 +1,344 @@
+#include "../../src/download/pkgdownloadtask.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <cstring>
+
+// 测试文件大小，正好可分为PKG_DOWNLOAD_SEGMENT_COUNT段
+#define TEST_FILE_SIZE (PKG_DOWNLOAD_SEGMENT_COUNT * PKG_DOWNLOAD_MIN_SEGMENT_SIZE)
+// 等待下载结束的超时（毫秒）
+#define TEST_DOWNLOAD_TIMEOUT_MS 30000
+
+// 范围请求格式：bytes=起点-[终点]
+static const QRegularExpression RangeHeaderRegular("^bytes=(\\d+)-(\\d*)$");
+
+// 本地HTTP服务器
+// 提供一个文件，可设置是否支持范围请求（不支持时总是返回200和整个文件），记录每个请求的Range请求头
+// 支持If-Range：与当前ETag不一致时返回200和整个文件
+class TestHttpServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit TestHttpServer(const QByteArray &content, bool isRangeSupported, QObject *parent = nullptr)
+        : QTcpServer(parent)
+        , m_content(content)
+        , m_isRangeSupported(isRangeSupported)
+        , m_etag("\"test\"")
+    {
+        connect(this, &QTcpServer::newConnection, this, &TestHttpServer::onNewConnection);
+    }
+
+    QString getUrl() const
+    {
+        return QString("http://127.0.0.1:%1/test.deb").arg(serverPort());
+    }
+
+    // 设置ETag，模拟服务器上的文件已变化
+    void setEtag(const QByteArray &etag)
+    {
+        m_etag = etag;
+    }
+
+    // 各请求的Range请求头，没有时为空
+    QList<QByteArray> getRangeList() const
+    {
+        return m_rangeList;
+    }
+
+private Q_SLOTS:
+    void onNewConnection()
+    {
+        while (hasPendingConnections()) {
+            QTcpSocket *socket = nextPendingConnection();
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                onSocketReadyRead(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+                m_requestMap.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+private:
+    void onSocketReadyRead(QTcpSocket *socket)
+    {
+        QByteArray &request = m_requestMap[socket];
+        request.append(socket->readAll());
+        if (!request.contains("\r\n\r\n")) {
+            return;
+        }
+
+        QByteArray range;
+        QByteArray ifRange;
+        const QList<QByteArray> lineList = request.left(request.indexOf("\r\n\r\n")).split('\n');
+        for (const QByteArray &line : lineList) {
+            if (line.toLower().startsWith("range:")) {
+                range = line.mid(int(strlen("range:"))).trimmed();
+            } else if (line.toLower().startsWith("if-range:")) {
+                ifRange = line.mid(int(strlen("if-range:"))).trimmed();
+            }
+        }
+        m_rangeList.append(range);
+        m_requestMap.remove(socket);
+
+        qint64 begin = 0;
+        qint64 end = m_content.size() - 1;
+        const QRegularExpressionMatch match = RangeHeaderRegular.match(QString::fromLatin1(range));
+        const bool isPartial = m_isRangeSupported && match.hasMatch() && (ifRange.isEmpty() || m_etag == ifRange);
+        if (isPartial) {
+            begin = match.captured(1).toLongLong();
+            if (!match.captured(2).isEmpty()) {
+                end = qMin(end, match.captured(2).toLongLong());
+            }
+        }
+
+        QByteArray header = isPartial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+        if (isPartial) {
+            header += QString("Content-Range: bytes %1-%2/%3\r\n").arg(begin).arg(end).arg(m_content.size()).toLatin1();
+        }
+        header += QString("Content-Length: %1\r\n").arg(end + 1 - begin).toLatin1();
+        header += "ETag: " + m_etag + "\r\n";
+        header += "Connection: close\r\n\r\n";
+        socket->write(header);
+        socket->write(m_content.mid(int(begin), int(end + 1 - begin)));
+        // 数据写完后断开
+        socket->disconnectFromHost();
+    }
+
+private:
+    QByteArray m_content;
+    bool m_isRangeSupported;
+    QByteArray m_etag;
+    QHash<QTcpSocket *, QByteArray> m_requestMap; // 连接 -> 未读完的请求
+    QList<QByteArray> m_rangeList;
+};
+
+// 安装包下载任务测试
+class TestPkgDownloadTask : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    // 支持范围请求时分段并行下载，大小已知和未知两种情况
+    void downloadSegments_data();
+    void downloadSegments();
+    // 服务器不支持范围请求时改为单连接下载
+    void fallbackToSingleConnection();
+    // 从.part文件和状态文件续传，只请求缺少的范围
+    void resumeFromPartFile();
+    // 状态文件中的ETag与服务器不一致时，If-Range请求返回200，重新分段下载整个文件
+    void restartWhenEtagChanged();
+    // 校验值不一致时失败，目标文件、.part文件和状态文件都不保留
+    void checksumMismatch();
+
+private:
+    // 开始下载并等待结束，返回是否成功
+    bool download(PkgDownloadTask &task);
+    static QByteArray readFile(const QString &filePath);
+
+private:
+    QByteArray m_content;
+    QString m_checksum;
+};
+
+void TestPkgDownloadTask::initTestCase()
+{
+    m_content.resize(TEST_FILE_SIZE);
+    for (int i = 0; i < m_content.size(); ++i) {
+        m_content[i] = char((i * 131 + i / 4096) & 0xff);
+    }
+    m_checksum = QString::fromLatin1(QCryptographicHash::hash(m_content, QCryptographicHash::Sha256).toHex());
+}
+
+void TestPkgDownloadTask::downloadSegments_data()
+{
+    QTest::addColumn<qint64>("fileSize");
+    QTest::newRow("known size") << qint64(TEST_FILE_SIZE);
+    QTest::newRow("unknown size") << qint64(-1);
+}
+
+void TestPkgDownloadTask::downloadSegments()
+{
+    QFETCH(qint64, fileSize);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestHttpServer server(m_content, true);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QNetworkAccessManager netManager;
+
+    const QString filePath = dir.filePath("test.deb");
+    PkgDownloadTask task(&netManager, server.getUrl(), filePath, fileSize, PKG_DOWNLOAD_SEGMENT_COUNT);
+    task.setChecksum(QCryptographicHash::Sha256, m_checksum);
+    QVERIFY(download(task));
+
+    QCOMPARE(readFile(filePath), m_content);
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_PART_FILE_SUFFIX));
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX));
+    // 第一段确认大小后再请求其余各段，每段一个请求
+    const QList<QByteArray> rangeList = server.getRangeList();
+    QCOMPARE(rangeList.size(), PKG_DOWNLOAD_SEGMENT_COUNT);
+    for (const QByteArray &range : rangeList) {
+        QVERIFY(range.startsWith("bytes="));
+    }
+}
+
+void TestPkgDownloadTask::fallbackToSingleConnection()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestHttpServer server(m_content, false);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QNetworkAccessManager netManager;
+
+    const QString filePath = dir.filePath("test.deb");
+    PkgDownloadTask task(&netManager, server.getUrl(), filePath, TEST_FILE_SIZE, PKG_DOWNLOAD_SEGMENT_COUNT);
+    task.setChecksum(QCryptographicHash::Sha256, m_checksum);
+    QVERIFY(download(task));
+
+    QCOMPARE(readFile(filePath), m_content);
+    // 第一段收到200后直接接收整个文件，不再请求其他段
+    QCOMPARE(server.getRangeList().size(), 1);
+}
+
+void TestPkgDownloadTask::resumeFromPartFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestHttpServer server(m_content, true);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QNetworkAccessManager netManager;
+
+    // 上次已下载前一半
+    const QString filePath = dir.filePath("test.deb");
+    const qint64 completedSize = TEST_FILE_SIZE / 2;
+    QFile partFile(filePath + PKG_DOWNLOAD_PART_FILE_SUFFIX);
+    QVERIFY(partFile.open(QIODevice::WriteOnly));
+    partFile.write(m_content.left(int(completedSize)));
+    partFile.write(QByteArray(int(TEST_FILE_SIZE - completedSize), '\0'));
+    partFile.close();
+    {
+        QSettings settings(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX, QSettings::Format::IniFormat);
+        settings.setValue("url", server.getUrl());
+        settings.setValue("fileSize", qint64(TEST_FILE_SIZE));
+        settings.setValue("ranges", QStringList {QString("0-%1").arg(completedSize)});
+        settings.sync();
+    }
+
+    PkgDownloadTask task(&netManager, server.getUrl(), filePath, TEST_FILE_SIZE, PKG_DOWNLOAD_SEGMENT_COUNT);
+    task.setChecksum(QCryptographicHash::Sha256, m_checksum);
+    QVERIFY(download(task));
+
+    QCOMPARE(readFile(filePath), m_content);
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX));
+    // 只请求后一半
+    const QList<QByteArray> rangeList = server.getRangeList();
+    QVERIFY(!rangeList.isEmpty());
+    for (const QByteArray &range : rangeList) {
+        const QRegularExpressionMatch match = RangeHeaderRegular.match(QString::fromLatin1(range));
+        QVERIFY(match.hasMatch());
+        QVERIFY(completedSize <= match.captured(1).toLongLong());
+    }
+}
+
+void TestPkgDownloadTask::restartWhenEtagChanged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestHttpServer server(m_content, true);
+    server.setEtag("\"new\"");
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QNetworkAccessManager netManager;
+
+    // 上次已下载旧文件的前一半
+    const QString filePath = dir.filePath("test.deb");
+    const qint64 completedSize = TEST_FILE_SIZE / 2;
+    QFile partFile(filePath + PKG_DOWNLOAD_PART_FILE_SUFFIX);
+    QVERIFY(partFile.open(QIODevice::WriteOnly));
+    partFile.write(QByteArray(int(completedSize), 'x'));
+    partFile.write(QByteArray(int(TEST_FILE_SIZE - completedSize), '\0'));
+    partFile.close();
+    {
+        QSettings settings(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX, QSettings::Format::IniFormat);
+        settings.setValue("url", server.getUrl());
+        settings.setValue("fileSize", qint64(TEST_FILE_SIZE));
+        settings.setValue("etag", "\"old\"");
+        settings.setValue("ranges", QStringList {QString("0-%1").arg(completedSize)});
+        settings.sync();
+    }
+
+    PkgDownloadTask task(&netManager, server.getUrl(), filePath, TEST_FILE_SIZE, PKG_DOWNLOAD_SEGMENT_COUNT);
+    task.setChecksum(QCryptographicHash::Sha256, m_checksum);
+    QVERIFY(download(task));
+
+    QCOMPARE(readFile(filePath), m_content);
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX));
+    // 续传请求收到200后，从头按段并行请求，每段一个请求
+    const QList<QByteArray> rangeList = server.getRangeList();
+    QCOMPARE(rangeList.size(), 1 + PKG_DOWNLOAD_SEGMENT_COUNT);
+    QVERIFY(rangeList.contains("bytes=0-" + QByteArray::number(PKG_DOWNLOAD_MIN_SEGMENT_SIZE - 1)));
+}
+
+void TestPkgDownloadTask::checksumMismatch()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestHttpServer server(m_content, true);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    QNetworkAccessManager netManager;
+
+    const QString filePath = dir.filePath("test.deb");
+    PkgDownloadTask task(&netManager, server.getUrl(), filePath, TEST_FILE_SIZE, PKG_DOWNLOAD_SEGMENT_COUNT);
+    const QString wrongChecksum = QString::fromLatin1(
+        QCryptographicHash::hash(m_content + "x", QCryptographicHash::Sha256).toHex());
+    task.setChecksum(QCryptographicHash::Sha256, wrongChecksum);
+    QSignalSpy failedSpy(&task, &PkgDownloadTask::failed);
+    QVERIFY(!download(task));
+
+    QCOMPARE(failedSpy.size(), 1);
+    QVERIFY(!QFile::exists(filePath));
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_PART_FILE_SUFFIX));
+    QVERIFY(!QFile::exists(filePath + PKG_DOWNLOAD_STATE_FILE_SUFFIX));
+}
+
+bool TestPkgDownloadTask::download(PkgDownloadTask &task)
+{
+    QSignalSpy finishedSpy(&task, &PkgDownloadTask::finished);
+    QSignalSpy failedSpy(&task, &PkgDownloadTask::failed);
+    task.start();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (finishedSpy.isEmpty() && failedSpy.isEmpty() && TEST_DOWNLOAD_TIMEOUT_MS > timer.elapsed()) {
+        QTest::qWait(10);
+    }
+    if (!failedSpy.isEmpty()) {
+        qWarning() << Q_FUNC_INFO << failedSpy.first().first().toString();
+    }
+    return !finishedSpy.isEmpty();
+}
+
+QByteArray TestPkgDownloadTask::readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QTEST_GUILESS_MAIN(TestPkgDownloadTask)
+
+#include "tst_pkgdownloadtask.moc"
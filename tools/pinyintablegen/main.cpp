@@ -0,0 +1,109 @@
+#include "../../src/common/pinyintable.h"
+
+#include <DtkCores>
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+// 每行输出的下标个数
+#define INDEX_COUNT_PER_LINE 16
+
+// 音节池
+class SyllablePool
+{
+public:
+    // 将音节加入音节池，返回在池中的下标
+    quint16 add(const QString &syllable)
+    {
+        int index = m_syllableIndexMap.value(syllable, -1);
+        if (-1 == index) {
+            index = m_syllableList.size();
+            m_syllableList.append(syllable);
+            m_syllableIndexMap.insert(syllable, index);
+        }
+        return quint16(index);
+    }
+
+    const QStringList &getSyllableList() const
+    {
+        return m_syllableList;
+    }
+
+private:
+    QStringList m_syllableList;
+    QHash<QString, int> m_syllableIndexMap; // 音节 -> 在音节池中的下标
+};
+
+static void writeIndexArray(QTextStream &stream, const char *name, const QVector<quint16> &indexList)
+{
+    stream << "static const quint16 " << name << "[PINYIN_TABLE_LAST_CHAR - PINYIN_TABLE_FIRST_CHAR + 1] = {\n";
+    for (int i = 0; i < indexList.size(); ++i) {
+        stream << (0 == i % INDEX_COUNT_PER_LINE ? "    " : " ") << indexList.at(i) << ",";
+        if (INDEX_COUNT_PER_LINE - 1 == i % INDEX_COUNT_PER_LINE || indexList.size() - 1 == i) {
+            stream << "\n";
+        }
+    }
+    stream << "};\n\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (2 != argc) {
+        qWarning() << "usage: pinyintablegen <output file>";
+        return 1;
+    }
+
+    SyllablePool pool;
+    QVector<quint16> tonedIndexList;
+    QVector<quint16> noToneIndexList;
+    for (int unicode = PINYIN_TABLE_FIRST_CHAR; unicode <= PINYIN_TABLE_LAST_CHAR; ++unicode) {
+        const QChar character(unicode);
+        QString tonedPinYin = Dtk::Core::Chinese2Pinyin(character);
+        // 没有读音的字符保持原样
+        if (tonedPinYin.isEmpty()) {
+            tonedPinYin = character;
+        }
+
+        // 去除声调数字
+        QString noTonePinYin;
+        for (const QChar &pinYinChar : tonedPinYin) {
+            if (!pinYinChar.isDigit()) {
+                noTonePinYin.append(pinYinChar);
+            }
+        }
+        if (noTonePinYin.isEmpty()) {
+            noTonePinYin = character;
+        }
+
+        tonedIndexList.append(pool.add(tonedPinYin));
+        noToneIndexList.append(pool.add(noTonePinYin));
+    }
+
+    QFile file(QString::fromLocal8Bit(argv[1]));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "open failed:" << file.fileName() << file.errorString();
+        return 1;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "// 由tools/pinyintablegen在构建时生成，请勿修改\n";
+    stream << "#pragma once\n\n";
+    stream << "#include <QtGlobal>\n\n";
+    stream << "#define PINYIN_TABLE_SYLLABLE_COUNT " << pool.getSyllableList().size() << "\n\n";
+    // 音节池，UTF-8编码
+    stream << "static const char *const PinyinSyllables[PINYIN_TABLE_SYLLABLE_COUNT] = {\n";
+    for (const QString &syllable : pool.getSyllableList()) {
+        stream << "    \"" << syllable << "\",\n";
+    }
+    stream << "};\n\n";
+    writeIndexArray(stream, "PinyinTonedIndexes", tonedIndexList);
+    writeIndexArray(stream, "PinyinNoToneIndexes", noToneIndexList);
+    stream.flush();
+
+    return QTextStream::Ok == stream.status() ? 0 : 1;
+}
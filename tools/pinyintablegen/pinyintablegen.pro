@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# 构建时生成汉字拼音表数据，由ccc-app-manager.pro调用
+# pinyintablegen <输出文件>
+#
+#-------------------------------------------------
+
+QT       += core dtkcore
+QT       -= gui
+
+TARGET = pinyintablegen
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp